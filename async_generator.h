@@ -0,0 +1,214 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * A C++20 coroutine generator whose body may co_await (e.g., non-blocking I/O)
+ * between its co_yield expressions, and whose consumer - itself a coroutine -
+ * co_awaits each next value, so a single thread can interleave many streams
+ * instead of blocking a thread per stream.
+ */
+#ifndef ASYNC_GENERATOR_H
+#define ASYNC_GENERATOR_H
+
+#include <concepts>
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <source_location>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+#include "generator.h"
+
+namespace coro {
+
+  /**
+   * Asynchronous coroutine generator template class. The consumer co_awaits
+   * next(), which resumes the generator's coroutine via symmetric transfer; once
+   * the coroutine reaches a co_yield (or completes), it resumes the consumer
+   * likewise. Should the coroutine instead suspend on some other co_await (say, an
+   * I/O operation), control returns to whoever resumed the consumer (e.g., an event
+   * loop), and the consumer is resumed by the thread that then resumes the
+   * coroutine and has it reach its next co_yield.
+   *
+   * The coroutine frame is allocated the same way as that of coro::generator<T>.
+   *
+   *   task<> consume(async_generator<record> records) {
+   *     while (co_await records.next()) {
+   *       process(records.getValueRef());
+   *     }
+   *   }
+   *
+   * @tparam T the type of value that the generator returns to the caller
+   * @tparam ExceptionPolicy what becomes of an exception escaping the coroutine (refer to generator.h)
+   * @tparam AllocationPolicy how the coroutine frame is allocated (refer to generator.h)
+   */
+  template<typename T, exception_policy ExceptionPolicy = propagate_exceptions,
+           allocation_policy AllocationPolicy = pmr_allocation>
+  class [[nodiscard]] async_generator {
+    static_assert(std::is_object_v<T>, "async_generator<T> requires an object type");
+  public:
+    using value_type = std::remove_cv_t<T>;
+    struct promise_type;
+    using coro_handle_type = std::coroutine_handle<promise_type>;
+  private:
+    coro_handle_type coro;
+  public:
+    explicit async_generator(coro_handle_type h) : coro{h} {}
+    async_generator(const async_generator &) = delete;            // do not allow copy construction
+    async_generator &operator=(const async_generator &) = delete; // do not allow copy assignment
+    async_generator(async_generator &&oth) noexcept : coro{std::exchange(oth.coro, nullptr)} {}
+    async_generator &operator=(async_generator &&other) noexcept {
+      if (this != &other) { // ignore assignment to self
+        if (coro) {         // destroy self current handle
+          coro.destroy();
+        }
+        coro = std::exchange(other.coro, nullptr);
+      }
+      return *this;
+    }
+    ~async_generator() {
+      if (coro) {
+        coro.destroy();
+        coro = nullptr;
+      }
+    }
+
+  private:
+    struct next_awaiter {
+      coro_handle_type coro;
+      bool await_ready() const noexcept {
+        return !coro || coro.done();
+      }
+      coro_handle_type await_suspend(std::coroutine_handle<> consumer) noexcept {
+        coro.promise().consumer = consumer;
+        return coro;
+      }
+      bool await_resume() {
+        if (!coro) return false;
+        if (coro.done()) {
+          coro.promise().rethrow_if_exception();
+          return false;
+        }
+        return true;
+      }
+    };
+
+  public: // API
+    /**
+     * Awaitable that resumes the coroutine until its next co_yield, and which
+     * evaluates to false once the coroutine has completed.
+     * Must not be awaited again before the preceding co_await has resumed.
+     */
+    next_awaiter next() const noexcept {
+      return next_awaiter{coro};
+    }
+
+    // binds the token that co_await this_stop_token() evaluates to within the coroutine (refer to generator.h)
+    void set_stop_token(std::stop_token token) noexcept {
+      if (coro) coro.promise().stop_token = std::move(token);
+    }
+
+    std::optional<T> getValue() noexcept {
+      return has_value() ? std::make_optional(*coro.promise().current_value) : std::nullopt;
+    }
+
+    /**
+     * Zero-copy access to the value most recently yielded by the coroutine; the
+     * reference remains valid until next() is awaited again.
+     * Precondition: the preceding co_await of next() evaluated to true.
+     */
+    T& getValueRef() const noexcept {
+      assert(has_value());
+      return *coro.promise().current_value;
+    }
+
+  private:
+    bool has_value() const noexcept {
+      return coro && !coro.done() && coro.promise().current_value != nullptr;
+    }
+
+  public:
+    // implementation of above opaque declaration promise_type
+    struct promise_type : promise_allocation<AllocationPolicy>, promise_exception<ExceptionPolicy> {
+    private:
+      value_type* current_value = nullptr;
+      std::coroutine_handle<> consumer{}; // the coroutine that most recently awaited next()
+      std::stop_token stop_token;
+      friend class async_generator;
+
+      // returns control to the consumer (a co_yield, or completion of the coroutine)
+      struct consumer_awaiter {
+        constexpr bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(coro_handle_type h) noexcept {
+          return h.promise().consumer;
+        }
+        constexpr void await_resume() const noexcept {}
+      };
+    public:
+      // the default argument is the source location of the coroutine (generator) function
+      promise_type(const std::source_location& loc = std::source_location::current()) {
+        this->record_frame_size(loc);
+      }
+      ~promise_type() = default;
+      promise_type(const promise_type&) = delete;
+      promise_type(promise_type&&) = delete;
+      promise_type &operator=(const promise_type&) = delete;
+      promise_type &operator=(promise_type&&) = delete;
+
+      auto get_return_object() {
+        return async_generator{coro_handle_type::from_promise(*this)};
+      }
+
+      auto initial_suspend() {
+        return std::suspend_always{};
+      }
+
+      auto final_suspend() noexcept {
+        current_value = nullptr;
+        return consumer_awaiter{};
+      }
+
+      void return_void() {}
+
+      detail::stop_token_awaiter await_transform(this_stop_token_t) noexcept {
+        return {stop_token};
+      }
+
+      // any other awaitable (e.g., an I/O operation) is awaited as is
+      template<typename A>
+      A&& await_transform(A&& awaitable) noexcept {
+        return std::forward<A>(awaitable);
+      }
+
+      // yielding an lvalue does not copy - the consumer is handed a reference to it
+      auto yield_value(value_type& some_value) noexcept {
+        current_value = std::addressof(some_value);
+        return consumer_awaiter{};
+      }
+
+      // a yielded rvalue (temporary) lives until the coroutine resumes, so the
+      // consumer may move from it
+      auto yield_value(value_type&& some_value) noexcept {
+        current_value = std::addressof(some_value);
+        return consumer_awaiter{};
+      }
+
+      // a const lvalue is copied into the awaiter, which lives in the frame for the
+      // duration of the suspension
+      auto yield_value(const value_type& some_value) requires std::copy_constructible<value_type> {
+        struct copy_awaiter : consumer_awaiter {
+          value_type value_copy;
+          std::coroutine_handle<> await_suspend(coro_handle_type h) noexcept {
+            h.promise().current_value = std::addressof(value_copy);
+            return h.promise().consumer;
+          }
+        };
+        return copy_awaiter{{}, some_value};
+      }
+    };
+  };
+
+} // namespace coro
+
+#endif //ASYNC_GENERATOR_H
@@ -0,0 +1,226 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * A C++20 coroutine generator that delivers its values to the consumer in
+ * batches (contiguous spans), so that the cost of resuming the coroutine is
+ * amortised over up to N values and the consumer can process each batch with
+ * vectorizable loops.
+ */
+#ifndef BATCH_GENERATOR_H
+#define BATCH_GENERATOR_H
+
+#include <array>
+#include <concepts>
+#include <coroutine>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+#include "generator.h"
+
+namespace coro {
+
+  /**
+   * Coroutine generator template class that buffers the values yielded by the
+   * coroutine and only suspends the coroutine once N values have been buffered
+   * (or when the coroutine completes), i.e., co_yield of a single value costs no
+   * more than a store into the promise's buffer.
+   *
+   * The coroutine may also co_yield a std::span of values directly, which is handed
+   * to the consumer as is (without copying) once any buffered values have been
+   * delivered.
+   *
+   * @tparam T the type of value that the generator returns to the caller
+   * @tparam N the (maximum) number of values per batch
+   * @tparam ExceptionPolicy what becomes of an exception escaping the coroutine (refer to generator.h)
+   * @tparam AllocationPolicy how the coroutine frame is allocated (refer to generator.h)
+   */
+  template<typename T, std::size_t N, exception_policy ExceptionPolicy = propagate_exceptions,
+           allocation_policy AllocationPolicy = pmr_allocation>
+  class [[nodiscard]] batch_generator
+      : public std::ranges::view_interface<batch_generator<T, N, ExceptionPolicy, AllocationPolicy>> {
+    static_assert(N > 0, "batch_generator<T, N> requires N > 0");
+  public:
+    using value_type = std::remove_cv_t<T>;
+    using batch_type = std::span<const value_type>;
+    static_assert(std::default_initializable<value_type> && std::copyable<value_type>,
+                  "batch_generator<T, N> requires a default-initializable, copyable T");
+    struct promise_type;
+    using coro_handle_type = std::coroutine_handle<promise_type>;
+  private:
+    coro_handle_type coro;
+  public:
+    explicit batch_generator(coro_handle_type h) : coro{h} {}
+    batch_generator(const batch_generator &) = delete;            // do not allow copy construction
+    batch_generator &operator=(const batch_generator &) = delete; // do not allow copy assignment
+    batch_generator(batch_generator &&oth) noexcept : coro{std::move(oth.coro)} {
+      oth.coro = nullptr; // insure the other moved handle is null
+    }
+    batch_generator &operator=(batch_generator &&other) noexcept {
+      if (this != &other) { // ignore assignment to self
+        if (coro) {         // destroy self current handle
+          coro.destroy();
+        }
+        coro = std::move(other.coro); // move other coro handle into self
+        other.coro = nullptr;         // insure other moved handle is null
+      }
+      return *this;
+    }
+    ~batch_generator() {
+      if (coro) {
+        coro.destroy();
+        coro = nullptr;
+      }
+    }
+
+  public: // API
+    /**
+     * Advances to the next batch of values.
+     *
+     * @return false once the coroutine has completed and all its values have been delivered
+     */
+    bool next() const {
+      return coro && coro.promise().advance(coro);
+    }
+
+    /**
+     * The current batch - remains valid until the next call to next().
+     * Precondition: the preceding call to next() returned true.
+     */
+    batch_type getBatch() const noexcept {
+      assert(coro);
+      return coro.promise().current;
+    }
+
+  public:
+    // implementation of above opaque declaration promise_type
+    struct promise_type : promise_allocation<AllocationPolicy>, promise_exception<ExceptionPolicy> {
+    private:
+      std::array<value_type, N> buf{};
+      std::size_t count = 0;
+      batch_type current{}; // batch that the consumer is presently processing
+      batch_type pending{}; // a yielded span that is to be delivered after the buffered values
+      friend class batch_generator;
+
+      struct batch_awaiter {
+        bool suspend;
+        constexpr bool await_ready() const noexcept { return !suspend; }
+        constexpr void await_suspend(coro_handle_type) const noexcept {}
+        constexpr void await_resume() const noexcept {}
+      };
+
+      bool publish_buffered() noexcept {
+        current = batch_type{buf.data(), count};
+        count = 0; // the consumer is done with the batch by the time the coroutine resumes
+        return true;
+      }
+
+      bool advance(coro_handle_type h) {
+        if (!pending.empty()) {
+          current = std::exchange(pending, batch_type{});
+          return true;
+        }
+        if (h.done()) return false; // nothing more to process
+        h.resume();
+        if (h.done()) {
+          this->rethrow_if_exception(); // values buffered ahead of the exception are discarded
+          return count > 0 && publish_buffered(); // deliver the final, partially filled, batch
+        }
+        return true;
+      }
+
+    public:
+      // the default argument is the source location of the coroutine (generator) function
+      promise_type(const std::source_location& loc = std::source_location::current()) {
+        this->record_frame_size(loc);
+      }
+      ~promise_type() = default;
+      promise_type(const promise_type&) = delete;
+      promise_type(promise_type&&) = delete;
+      promise_type &operator=(const promise_type&) = delete;
+      promise_type &operator=(promise_type&&) = delete;
+
+      auto get_return_object() {
+        return batch_generator{coro_handle_type::from_promise(*this)};
+      }
+
+      auto initial_suspend() {
+        return std::suspend_always{};
+      }
+
+      auto final_suspend() noexcept {
+        return std::suspend_always{};
+      }
+
+      void return_void() {}
+
+      batch_awaiter yield_value(const value_type& some_value) {
+        buf[count++] = some_value;
+        return batch_awaiter{count == N && publish_buffered()};
+      }
+
+      batch_awaiter yield_value(value_type&& some_value) {
+        buf[count++] = std::move(some_value);
+        return batch_awaiter{count == N && publish_buffered()};
+      }
+
+      // the span must remain valid until the coroutine resumes
+      batch_awaiter yield_value(batch_type some_values) noexcept {
+        if (some_values.empty()) return batch_awaiter{false};
+        if (count > 0) {
+          publish_buffered();
+          pending = some_values;
+        } else {
+          current = some_values;
+        }
+        return batch_awaiter{true};
+      }
+    };
+
+    struct iterator {
+      using difference_type [[maybe_unused]] = std::ptrdiff_t;
+      using value_type [[maybe_unused]] = batch_type;
+      coro_handle_type hdl = nullptr;
+      iterator() = default;
+      iterator(coro_handle_type h) : hdl{h} {}
+      void getNext() {
+        if (hdl && !hdl.promise().advance(hdl)) {
+          hdl = nullptr;
+        }
+      }
+      batch_type operator*() const {
+        assert(hdl);
+        return hdl.promise().current;
+      }
+      iterator& operator++() { // pre-incrementable
+        getNext();
+        return *this;
+      }
+      void operator ++ (int) { // post-incrementable
+       ++*this;
+      }
+      bool operator==(const iterator& i) const = default;
+      bool operator==(std::default_sentinel_t) const noexcept {
+        return !hdl; // delivered the final batch
+      }
+    };
+
+    iterator begin() const {
+      if (!coro || coro.done()) {
+        return iterator{nullptr};
+      }
+      iterator itr{coro};
+      itr.getNext();
+      return itr;
+    }
+
+    std::default_sentinel_t end() const noexcept {
+      return std::default_sentinel;
+    }
+  };
+
+} // namespace coro
+
+#endif //BATCH_GENERATOR_H
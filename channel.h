@@ -0,0 +1,416 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Bounded, lock-free channels for handing values between threads, e.g., from a
+ * generator running on a background thread to the consumer's thread (refer to
+ * prefetch.h and fanout.h).
+ */
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+
+namespace coro {
+
+  // assumed size of a cache line, i.e., the granularity of false sharing
+  inline constexpr std::size_t cache_line_size = 64;
+
+  namespace detail {
+
+    inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#elif defined(__aarch64__)
+      asm volatile("yield");
+#endif
+    }
+
+    // spins, then yields the CPU, for a while before a waiting side blocks
+    class backoff {
+    private:
+      static constexpr int spin_count = 256;
+      static constexpr int yield_count = 16;
+      int count = 0;
+    public:
+      // false once the caller should block instead
+      bool pause() noexcept {
+        if (count < spin_count) {
+          cpu_relax();
+        } else if (count < spin_count + yield_count) {
+          std::this_thread::yield(); // lets the other side run, should it share the CPU
+        } else {
+          return false;
+        }
+        count++;
+        return true;
+      }
+    };
+
+    // waits (via backoff and then std::atomic<>::wait()) until the index differs from old
+    inline std::size_t wait_for_change(const std::atomic<std::size_t>& index, std::size_t old) noexcept {
+      for (backoff b; b.pause(); ) {
+        const auto current = index.load(std::memory_order_acquire);
+        if (current != old) return current;
+      }
+      index.wait(old, std::memory_order_acquire);
+      return index.load(std::memory_order_acquire);
+    }
+
+  } // namespace detail
+
+  /**
+   * Bounded, lock-free, single-producer single-consumer ring buffer.
+   *
+   * The producer and the consumer each own an index on its own cache line and keep
+   * a cached copy of the other's index, so they only read each other's cache line
+   * once the cached copy is exhausted. In addition, the producer only publishes its
+   * index once per batch of values (or when the ring is full, or on close()), and
+   * the consumer likewise only releases slots once per batch, so that for a batch of
+   * N values the cache lines of the indices change hands once rather than N times.
+   * A side that finds the ring full (or empty) spins (and then yields) briefly before it blocks.
+   *
+   * The producer closes the channel when done (optionally with an exception for the
+   * consumer), and the consumer may cancel it, which unblocks and stops the producer.
+   *
+   * The channel is cache-line aligned, so it must not be a local variable of a
+   * coroutine (whose frame is not), but one allocated with operator new.
+   *
+   * @tparam T the type of value passed through the channel
+   */
+  template<typename T>
+  class spsc_channel {
+    static_assert(std::is_nothrow_destructible_v<T>, "spsc_channel<T> requires a nothrow destructible T");
+  private:
+    // flags the index of the closing side (producer: closed, consumer: cancelled)
+    static constexpr std::size_t end_flag = std::size_t{1} << (std::numeric_limits<std::size_t>::digits - 1);
+
+    struct slot {
+      alignas(T) std::byte storage[sizeof(T)];
+      T* get() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    const std::size_t mask;
+    const std::size_t batch;
+    std::unique_ptr<slot[]> slots;
+    std::exception_ptr exception{};
+
+    // the producer's side
+    alignas(cache_line_size) std::atomic<std::size_t> tail{0}; // published by the producer
+    std::size_t write_index = 0;
+    std::size_t published_index = 0;
+    std::size_t cached_head = 0;
+
+    // the consumer's side
+    alignas(cache_line_size) std::atomic<std::size_t> head{0}; // released by the consumer
+    std::size_t read_index = 0;
+    std::size_t released_index = 0;
+    std::size_t cached_tail = 0;
+    bool closed_seen = false;
+
+  public:
+    /**
+     * @param capacity the number of values the ring holds (rounded up to a power of two)
+     * @param batch_size the number of values per index publication (clamped to the capacity)
+     */
+    explicit spsc_channel(std::size_t capacity, std::size_t batch_size = 1)
+      : mask{std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1},
+        batch{std::clamp<std::size_t>(batch_size, 1, mask + 1)},
+        slots{std::make_unique<slot[]>(mask + 1)} {}
+    spsc_channel(const spsc_channel&) = delete;
+    spsc_channel& operator=(const spsc_channel&) = delete;
+    ~spsc_channel() { // neither side may be accessing the channel any longer
+      for (auto i = read_index; i != write_index; i++) {
+        std::destroy_at(slots[i & mask].get());
+      }
+    }
+
+    std::size_t capacity() const noexcept { return mask + 1; }
+
+    // producer API
+
+    /**
+     * Blocks while the ring is full.
+     * @return false once the consumer has cancelled the channel (which is only checked
+     *         once per batch; the value is discarded if the channel was cancelled already)
+     */
+    template<typename U>
+    bool push(U&& value) {
+      if (write_index - cached_head > mask) {
+        publish(); // let the consumer drain the full ring
+        if (!wait_for_space()) return false;
+      }
+      std::construct_at(slots[write_index & mask].get(), std::forward<U>(value));
+      if (++write_index - published_index >= batch) {
+        publish();
+        return !cancelled();
+      }
+      return true;
+    }
+
+    // ends the channel once the consumer has received all the values pushed (and the exception, if any)
+    void close(std::exception_ptr ex = nullptr) noexcept {
+      exception = std::move(ex); // published by the release store of the tail
+      published_index = write_index;
+      tail.store(write_index | end_flag, std::memory_order_release);
+      tail.notify_one();
+    }
+
+    bool cancelled() const noexcept {
+      return (head.load(std::memory_order_relaxed) & end_flag) != 0;
+    }
+
+    // consumer API
+
+    /**
+     * Blocks while the ring is empty.
+     * @return the oldest value in the ring (which the consumer may move from), or
+     *         nullptr once the channel is closed and drained
+     */
+    T* front() noexcept {
+      if (read_index == cached_tail && !wait_for_values()) return nullptr;
+      return slots[read_index & mask].get();
+    }
+
+    // removes the value returned by front()
+    void pop() noexcept {
+      assert(read_index != cached_tail);
+      std::destroy_at(slots[read_index & mask].get());
+      if (++read_index - released_index >= batch) {
+        release();
+      }
+    }
+
+    // stops the producer (the values remaining in the ring are destroyed with the channel)
+    void cancel() noexcept {
+      head.store(read_index | end_flag, std::memory_order_release);
+      head.notify_one();
+    }
+
+    // rethrows the exception that the producer closed the channel with, if any (once drained)
+    void rethrow_if_exception() {
+      if (closed_seen && exception) {
+        std::rethrow_exception(std::exchange(exception, nullptr));
+      }
+    }
+
+  private:
+    void publish() noexcept {
+      published_index = write_index;
+      tail.store(write_index, std::memory_order_release);
+      tail.notify_one();
+    }
+
+    void release() noexcept {
+      if (released_index == read_index) return;
+      released_index = read_index;
+      head.store(read_index, std::memory_order_release);
+      head.notify_one();
+    }
+
+    bool wait_for_space() noexcept {
+      auto h = head.load(std::memory_order_acquire);
+      while (write_index - (h & ~end_flag) > mask) {
+        if (h & end_flag) return false;
+        h = detail::wait_for_change(head, h);
+      }
+      if (h & end_flag) return false;
+      cached_head = h;
+      return true;
+    }
+
+    bool wait_for_values() noexcept {
+      release(); // let the producer fill the empty ring
+      auto t = tail.load(std::memory_order_acquire);
+      while ((t & ~end_flag) == read_index) {
+        if (t & end_flag) {
+          closed_seen = true;
+          return false;
+        }
+        t = detail::wait_for_change(tail, t);
+      }
+      cached_tail = t & ~end_flag;
+      return true;
+    }
+  };
+
+  /**
+   * Bounded, lock-free, multi-producer single-consumer queue (after Dmitry Vyukov's
+   * bounded MPMC queue): each slot carries a sequence number that tells producers
+   * and the consumer whose turn it is, so producers contend only on claiming a
+   * position and each value is handed over with a single release store.
+   *
+   * Producers that find the queue full spin (and then yield) briefly before they
+   * block on the slot they wait for. The consumer likewise blocks on an event count
+   * that a producer only signals if the consumer is actually waiting.
+   *
+   * The queue is closed once each of the producers it was created for has called
+   * close() (the first exception any of them closed with is kept for the consumer),
+   * and the consumer may cancel it, after which push() fails.
+   *
+   * The queue is cache-line aligned, so it must not be a local variable of a
+   * coroutine (whose frame is not), but one allocated with operator new.
+   *
+   * @tparam T the type of value passed through the queue
+   */
+  template<typename T>
+  class mpsc_channel {
+    static_assert(std::is_nothrow_destructible_v<T>, "mpsc_channel<T> requires a nothrow destructible T");
+  private:
+    struct slot {
+      std::atomic<std::size_t> seq;
+      alignas(T) std::byte storage[sizeof(T)];
+      T* get() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<slot[]> slots;
+
+    alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos{0};
+    std::atomic<bool> is_cancelled{false};
+
+    alignas(cache_line_size) std::atomic<std::size_t> producers;
+    std::atomic<bool> exception_set{false};
+    std::exception_ptr exception{}; // of the first producer to close with one
+
+    alignas(cache_line_size) std::atomic<std::uint32_t> consumer_epoch{0};
+    std::atomic<bool> consumer_waiting{false};
+
+    // the consumer's side
+    alignas(cache_line_size) std::size_t read_index = 0;
+
+  public:
+    /**
+     * @param capacity the number of values the queue holds (rounded up to a power of two)
+     * @param num_producers the number of producers that are each to close() the queue
+     */
+    mpsc_channel(std::size_t capacity, std::size_t num_producers)
+      : mask{std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1},
+        slots{std::make_unique<slot[]>(mask + 1)},
+        producers{num_producers} {
+      for (std::size_t i = 0; i <= mask; i++) {
+        slots[i].seq.store(i, std::memory_order_relaxed);
+      }
+    }
+    mpsc_channel(const mpsc_channel&) = delete;
+    mpsc_channel& operator=(const mpsc_channel&) = delete;
+    ~mpsc_channel() { // neither side may be accessing the queue any longer
+      while (front() != nullptr) {
+        pop();
+      }
+    }
+
+    // producer API
+
+    /**
+     * Blocks while the queue is full.
+     * @return false if the consumer has cancelled the queue (the value is discarded)
+     */
+    template<typename U>
+    bool push(U&& value) {
+      auto pos = enqueue_pos.load(std::memory_order_relaxed);
+      for (;;) {
+        if (is_cancelled.load(std::memory_order_relaxed)) return false;
+        auto& s = slots[pos & mask];
+        const auto seq = s.seq.load(std::memory_order_acquire);
+        const auto dif = static_cast<std::ptrdiff_t>(seq - pos);
+        if (dif == 0) {
+          if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+            std::construct_at(s.get(), std::forward<U>(value));
+            s.seq.store(pos + 1, std::memory_order_release);
+            wake_consumer();
+            return true;
+          }
+        } else if (dif < 0) { // full - wait for the consumer to free the slot
+          detail::wait_for_change(s.seq, seq);
+          pos = enqueue_pos.load(std::memory_order_relaxed);
+        } else { // claimed by another producer
+          pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    // called once by each of the producers when done (optionally with an exception for the consumer)
+    void close(std::exception_ptr ex = nullptr) noexcept {
+      if (ex && !exception_set.exchange(true, std::memory_order_relaxed)) {
+        exception = std::move(ex); // published by the release of the producer count
+      }
+      producers.fetch_sub(1, std::memory_order_acq_rel);
+      wake_consumer();
+    }
+
+    bool cancelled() const noexcept {
+      return is_cancelled.load(std::memory_order_relaxed);
+    }
+
+    // consumer API
+
+    /**
+     * Blocks while the queue is empty.
+     * @return the oldest value in the queue (which the consumer may move from), or
+     *         nullptr once all the producers have closed the queue and it is drained
+     */
+    T* front() noexcept {
+      auto& s = slots[read_index & mask];
+      for (detail::backoff b; ; ) {
+        if (s.seq.load(std::memory_order_acquire) == read_index + 1) return s.get();
+        if (producers.load(std::memory_order_acquire) == 0) {
+          // a value pushed before the final close() is visible by now
+          return s.seq.load(std::memory_order_acquire) == read_index + 1 ? s.get() : nullptr;
+        }
+        if (b.pause()) continue;
+        const auto epoch = consumer_epoch.load(std::memory_order_acquire);
+        consumer_waiting.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (s.seq.load(std::memory_order_acquire) != read_index + 1 && producers.load(std::memory_order_acquire) != 0) {
+          consumer_epoch.wait(epoch, std::memory_order_acquire);
+        }
+        consumer_waiting.store(false, std::memory_order_relaxed);
+      }
+    }
+
+    // removes the value returned by front()
+    void pop() noexcept {
+      auto& s = slots[read_index & mask];
+      std::destroy_at(s.get());
+      s.seq.store(read_index + mask + 1, std::memory_order_release);
+      s.seq.notify_all(); // any producers waiting for the slot
+      read_index++;
+    }
+
+    // makes push() fail from now on (the consumer should still drain the queue until the producers have closed it)
+    void cancel() noexcept {
+      is_cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    // rethrows the first exception that a producer closed the queue with, if any (once drained)
+    void rethrow_if_exception() {
+      if (producers.load(std::memory_order_acquire) == 0 && exception) {
+        std::rethrow_exception(std::exchange(exception, nullptr));
+      }
+    }
+
+  private:
+    void wake_consumer() noexcept {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (consumer_waiting.load(std::memory_order_relaxed)) {
+        consumer_epoch.fetch_add(1, std::memory_order_release);
+        consumer_epoch.notify_one();
+      }
+    }
+  };
+
+} // namespace coro
+
+#endif //CHANNEL_H
@@ -0,0 +1,266 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * A C++20 coroutine generator whose logical loop state is an explicit, trivially
+ * copyable State object held in the promise, which can be snapshotted to bytes
+ * and restored from them - so that after a restart a long running generator
+ * continues where the snapshot was taken instead of replaying from the start.
+ */
+#ifndef CHECKPOINTABLE_GENERATOR_H
+#define CHECKPOINTABLE_GENERATOR_H
+
+#include <array>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <source_location>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+#include "generator.h"
+
+namespace coro {
+
+  /**
+   * co_await checkpoint_state(initial) within the body of a checkpointable_generator
+   * evaluates to a reference to the State held by the promise, which is initialized
+   * to initial - unless the generator has been restored from a snapshot, in
+   * which case it holds the restored State.
+   */
+  template<typename State>
+  struct checkpoint_state {
+    State initial;
+  };
+  template<typename State>
+  checkpoint_state(State) -> checkpoint_state<State>;
+
+  /**
+   * Generator template class whose coroutine keeps all of its logical loop state in
+   * the State object obtained via co_await checkpoint_state(...), updating it before
+   * each co_yield such that it describes the remainder of the sequence, i.e., the
+   * values still to come after the value being yielded:
+   *
+   *   coro::checkpointable_generator<T, counter_state<T>> count_from(const T start) {
+   *     auto& s = co_await coro::checkpoint_state{counter_state<T>{start}};
+   *     while (true) {
+   *       T value = s.next++;
+   *       co_yield value;
+   *     }
+   *   }
+   *
+   * A snapshot() taken whilst the generator is suspended can then be restore()-d into
+   * a newly created generator (of the same function and arguments) before its first
+   * next(), which continues with the value following the last one delivered.
+   *
+   * @tparam T the type of value that the generator returns to the caller
+   * @tparam State the trivially copyable loop state of the coroutine
+   * @tparam ExceptionPolicy what becomes of an exception escaping the coroutine (refer to generator.h)
+   * @tparam AllocationPolicy how the coroutine frame is allocated (refer to generator.h)
+   */
+  template<typename T, typename State, exception_policy ExceptionPolicy = propagate_exceptions,
+           allocation_policy AllocationPolicy = pmr_allocation>
+  class [[nodiscard]] checkpointable_generator
+      : public std::ranges::view_interface<checkpointable_generator<T, State, ExceptionPolicy, AllocationPolicy>> {
+    static_assert(std::is_object_v<T>, "checkpointable_generator<T, State> requires an object type T");
+    static_assert(std::is_trivially_copyable_v<State> && std::default_initializable<State>,
+                  "checkpointable_generator<T, State> requires a trivially copyable, default-initializable State");
+  public:
+    using value_type = std::remove_cv_t<T>;
+    using snapshot_type = std::array<std::byte, sizeof(State)>;
+    struct promise_type;
+    using coro_handle_type = std::coroutine_handle<promise_type>;
+  private:
+    coro_handle_type coro;
+  public:
+    explicit checkpointable_generator(coro_handle_type h) : coro{h} {}
+    checkpointable_generator(const checkpointable_generator &) = delete;            // do not allow copy construction
+    checkpointable_generator &operator=(const checkpointable_generator &) = delete; // do not allow copy assignment
+    checkpointable_generator(checkpointable_generator &&oth) noexcept : coro{std::exchange(oth.coro, nullptr)} {}
+    checkpointable_generator &operator=(checkpointable_generator &&other) noexcept {
+      if (this != &other) { // ignore assignment to self
+        if (coro) {         // destroy self current handle
+          coro.destroy();
+        }
+        coro = std::exchange(other.coro, nullptr);
+      }
+      return *this;
+    }
+    ~checkpointable_generator() {
+      if (coro) {
+        coro.destroy();
+        coro = nullptr;
+      }
+    }
+
+  public: // API
+    bool next() const {
+      if (!coro || coro.done()) return false; // nothing more to process
+      coro.resume();
+      if (coro.done()) {
+        coro.promise().rethrow_if_exception();
+        return false;
+      }
+      return true;
+    }
+
+    std::optional<T> getValue() noexcept {
+      return has_value() ? std::make_optional(*coro.promise().current_value) : std::nullopt;
+    }
+
+    // refer to generator<T>::getValueRef()
+    T& getValueRef() const noexcept {
+      assert(has_value());
+      return *coro.promise().current_value;
+    }
+
+    /**
+     * The loop state of the coroutine, as bytes.
+     * @throws std::logic_error if the coroutine has not started yet, i.e., before the first next()
+     */
+    snapshot_type snapshot() const {
+      if (!coro || !coro.promise().started) {
+        throw std::logic_error{"checkpointable_generator::snapshot() before the coroutine has started"};
+      }
+      snapshot_type bytes;
+      std::memcpy(bytes.data(), std::addressof(coro.promise().state), sizeof(State));
+      return bytes;
+    }
+
+    /**
+     * Replaces the loop state that the coroutine is to start from with a snapshot.
+     * @throws std::logic_error if the coroutine has already started (or the generator is empty)
+     * @throws std::invalid_argument if the snapshot is not of the size of State
+     */
+    void restore(std::span<const std::byte> bytes) {
+      if (!coro || coro.promise().started) {
+        throw std::logic_error{"checkpointable_generator::restore() after the coroutine has started"};
+      }
+      if (bytes.size() != sizeof(State)) {
+        throw std::invalid_argument{"checkpointable_generator::restore() of a snapshot of another size"};
+      }
+      std::memcpy(std::addressof(coro.promise().state), bytes.data(), sizeof(State));
+      coro.promise().restored = true;
+    }
+
+  private:
+    bool has_value() const noexcept {
+      return coro && !coro.done() && coro.promise().current_value != nullptr;
+    }
+
+  public:
+    // implementation of above opaque declaration promise_type
+    struct promise_type : promise_allocation<AllocationPolicy>, promise_exception<ExceptionPolicy> {
+    private:
+      value_type* current_value = nullptr;
+      State state{};
+      bool restored = false;
+      bool started = false;
+      friend class checkpointable_generator;
+
+      struct state_awaiter {
+        State& state;
+        constexpr bool await_ready() const noexcept { return true; }
+        constexpr void await_suspend(coro_handle_type) const noexcept {}
+        State& await_resume() const noexcept { return state; }
+      };
+    public:
+      // the default argument is the source location of the coroutine (generator) function
+      promise_type(const std::source_location& loc = std::source_location::current()) {
+        this->record_frame_size(loc);
+      }
+      ~promise_type() = default;
+      promise_type(const promise_type&) = delete;
+      promise_type(promise_type&&) = delete;
+      promise_type &operator=(const promise_type&) = delete;
+      promise_type &operator=(promise_type&&) = delete;
+
+      auto get_return_object() {
+        return checkpointable_generator{coro_handle_type::from_promise(*this)};
+      }
+
+      auto initial_suspend() {
+        return std::suspend_always{};
+      }
+
+      auto final_suspend() noexcept {
+        return std::suspend_always{};
+      }
+
+      void return_void() {}
+
+      state_awaiter await_transform(checkpoint_state<State> cs) noexcept {
+        if (!restored) {
+          state = cs.initial;
+        }
+        started = true;
+        return state_awaiter{state};
+      }
+
+      // yielding an lvalue does not copy - the consumer is handed a reference to it
+      auto yield_value(value_type& some_value) noexcept {
+        current_value = std::addressof(some_value);
+        return std::suspend_always{};
+      }
+
+      auto yield_value(value_type&& some_value) noexcept {
+        current_value = std::addressof(some_value);
+        return std::suspend_always{};
+      }
+    };
+
+    struct iterator {
+      using difference_type [[maybe_unused]] = std::ptrdiff_t;
+      using value_type [[maybe_unused]] = checkpointable_generator::value_type;
+      coro_handle_type hdl = nullptr;
+      iterator() = default;
+      iterator(coro_handle_type h) : hdl{h} {}
+      void getNext() {
+        if (hdl) {
+          hdl.resume();
+          if (hdl.done()) {
+            auto done_hdl = std::exchange(hdl, nullptr);
+            done_hdl.promise().rethrow_if_exception();
+          }
+        }
+      }
+      T& operator*() const {
+        assert(hdl);
+        return *hdl.promise().current_value;
+      }
+      iterator& operator++() { // pre-incrementable
+        getNext();
+        return *this;
+      }
+      void operator ++ (int) { // post-incrementable
+       ++*this;
+      }
+      bool operator==(const iterator& i) const = default;
+      bool operator==(std::default_sentinel_t) const noexcept {
+        return !hdl; // reached the end of the sequence
+      }
+    };
+
+    iterator begin() const {
+      if (!coro || coro.done()) {
+        return iterator{nullptr};
+      }
+      iterator itr{coro};
+      itr.getNext();
+      return itr;
+    }
+
+    std::default_sentinel_t end() const noexcept {
+      return std::default_sentinel;
+    }
+  };
+
+} // namespace coro
+
+#endif //CHECKPOINTABLE_GENERATOR_H
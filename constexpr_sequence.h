@@ -0,0 +1,134 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * A sequence written once as a step function over explicit State - rather than as
+ * a coroutine body, which cannot be evaluated in a constant expression - that is a
+ * coro::generator at runtime and a std::array at compile time: a constant table of
+ * its values then costs nothing at startup and needs no coroutine frame.
+ */
+#ifndef CONSTEXPR_SEQUENCE_H
+#define CONSTEXPR_SEQUENCE_H
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "generator.h"
+
+namespace coro {
+
+  // Step is invocable on a State& and returns the next value of the sequence, or std::nullopt once it has ended
+  template<typename Step, typename State>
+  concept sequence_step = std::copy_constructible<State> && std::invocable<const Step&, State&>
+      && requires(const Step& step, State& state) {
+        { *step(state) };
+        { static_cast<bool>(step(state)) };
+      };
+
+  template<typename State, sequence_step<State> Step>
+  class constexpr_sequence;
+
+  namespace detail {
+
+    template<typename State, typename Step>
+    using sequence_value_t = std::remove_cvref_t<decltype(*std::declval<const Step&>()(std::declval<State&>()))>;
+
+    // (takes the sequence by value, so the generator does not refer to the constexpr_sequence it was created from)
+    template<typename State, typename Step>
+    generator<sequence_value_t<State, Step>> run_sequence(std::allocator_arg_t, std::pmr::memory_resource* mr,
+                                                          constexpr_sequence<State, Step> seq) {
+      auto state = seq.initial;
+      while (auto value = seq.step(state)) {
+        co_yield *value;
+      }
+    }
+
+  } // namespace detail
+
+  /**
+   * The sequence of values that the step function returns from successive calls on
+   * a copy of the initial state, until it returns std::nullopt:
+   * ```
+   *     constexpr coro::constexpr_sequence squares{0, [](int& k) -> std::optional<int> {
+   *       if (k == 10) return std::nullopt;
+   *       const int square = k * k;
+   *       k++;
+   *       return square;
+   *     }};
+   *     for (auto gen = squares(); gen.next(); ) ...         // at runtime
+   *     constexpr auto table = coro::sequence_table<squares>; // std::array<int, 10>, at compile time
+   * ```
+   * Where the state and the step function are literal types (e.g., a lambda without
+   * captures, or a lambda that captures only literal values such as a ceiling) the
+   * sequence can be evaluated in a constant expression via size() and to_array().
+   * The step function must be free of side effects other than on the state, as the
+   * sequence may be evaluated more than once. The members are public, so that a
+   * constexpr_sequence can be a template argument (of sequence_table).
+   *
+   * @tparam State the loop state of the sequence, copied for each evaluation
+   * @tparam Step the step function, invoked on a State& for each value
+   */
+  template<typename State, sequence_step<State> Step>
+  class constexpr_sequence {
+  public:
+    using state_type = State;
+    using value_type = detail::sequence_value_t<State, Step>;
+
+    State initial;
+    Step step;
+
+    constexpr constexpr_sequence(State initial_state, Step step_fn)
+      : initial{std::move(initial_state)}, step{std::move(step_fn)} {}
+
+    // the number of values of the sequence (which must end, for a constant expression to evaluate it)
+    constexpr std::size_t size() const {
+      auto state = initial;
+      std::size_t n = 0;
+      while (step(state)) n++;
+      return n;
+    }
+
+    /**
+     * Returns the first N values of the sequence. Throws std::length_error should the
+     * sequence end before N values - i.e., in a constant expression, fails to compile.
+     */
+    template<std::size_t N>
+    constexpr std::array<value_type, N> to_array() const {
+      std::array<value_type, N> values{};
+      auto state = initial;
+      for (auto& v : values) {
+        auto value = step(state);
+        if (!value) throw std::length_error{"constexpr_sequence ended before the size of the array"};
+        v = std::move(*value);
+      }
+      return values;
+    }
+
+    // a generator of the sequence, whose frame is allocated from mr
+    generator<value_type> operator()(std::allocator_arg_t, std::pmr::memory_resource* mr) const {
+      return detail::run_sequence(std::allocator_arg, mr, *this);
+    }
+
+    // a generator of the sequence, whose frame is allocated from the thread's pmr allocator (refer to set_pmr_mem_pool())
+    generator<value_type> operator()() const {
+      return (*this)(std::allocator_arg, pmem_pool);
+    }
+  };
+
+  /**
+   * All the values of the sequence, as a std::array evaluated at compile time - the
+   * sequence must end, and be usable as a template argument (i.e., be constexpr, its
+   * state and step function having only public members, as a lambda without captures
+   * has - a lambda's captures are not public members).
+   */
+  template<auto Seq>
+  inline constexpr auto sequence_table = Seq.template to_array<Seq.size()>();
+
+} // namespace coro
+
+#endif //CONSTEXPR_SEQUENCE_H
@@ -0,0 +1,713 @@
+/** coro_bench.cpp
+ *
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Licensed under the MIT License - refer to LICENSE project document.
+ *
+ * Google Benchmark microbenchmarks measuring the cost per element of consuming
+ * the ascending_sequence() and fibonacci() generators, per value type, per
+ * manner of consumption, and per pmr allocator of the coroutine frames.
+ *
+ * Run with, e.g.:
+ * ./coro_bench --benchmark_filter=fibonacci --benchmark_counters_tabular=true
+ */
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <memory_resource>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "generator.h"
+#include "async_generator.h"
+#include "batch_generator.h"
+#include "fanout.h"
+#include "file_records.h"
+#include "numa_frame_resource.h"
+#include "pipeline.h"
+#include "prefetch.h"
+#include "scheduler.h"
+#include "sequences.h"
+#include "sink.h"
+#include "splittable_generator.h"
+#include "task.h"
+#include "tee.h"
+
+namespace {
+
+  // the same ceilings as the demo program
+  template<arithmetic T>
+  constexpr T ceiling_of() {
+    if constexpr (std::integral<T>) {
+      return std::numeric_limits<T>::max() / T(1'000);
+    } else {
+      return std::numeric_limits<T>::max() / T(1'000.0f);
+    }
+  }
+
+  template<arithmetic T>
+  int64_t fibonacci_length(const T ceiling) {
+    static const int64_t length = [ceiling] {
+      int64_t n = 0;
+      for (auto gen = fibonacci(ceiling); gen.next(); n++) {}
+      return n;
+    }();
+    return length;
+  }
+
+  enum class consumption { next_get_value, next_get_value_ref, iterator, ranges_for_each };
+
+  template<consumption C, typename Gen>
+  void consume(Gen& gen, std::size_t count) {
+    if constexpr (C == consumption::next_get_value) {
+      for (std::size_t i = 0; i < count && gen.next(); i++) {
+        benchmark::DoNotOptimize(gen.getValue());
+      }
+    } else if constexpr (C == consumption::next_get_value_ref) {
+      for (std::size_t i = 0; i < count && gen.next(); i++) {
+        benchmark::DoNotOptimize(gen.getValueRef());
+      }
+    } else if constexpr (C == consumption::iterator) {
+      std::size_t i = 0;
+      for (auto itr = gen.begin(); i < count && itr != gen.end(); ++itr, i++) {
+        benchmark::DoNotOptimize(*itr);
+      }
+    } else {
+      const auto f = [](const auto& value) { benchmark::DoNotOptimize(value); };
+      if (count == std::numeric_limits<std::size_t>::max()) {
+        std::ranges::for_each(gen, f); // the whole (finite) sequence
+      } else {
+        std::ranges::for_each(std::views::counted(gen.begin(), static_cast<std::ptrdiff_t>(count)), f);
+      }
+    }
+  }
+
+  // steady state cost per element, i.e., without the frame allocation
+  template<arithmetic T, consumption C>
+  void BM_ascending_sequence(benchmark::State& state) {
+    constexpr std::size_t elements_per_iteration = 1'000;
+    auto gen = ascending_sequence(T{0});
+    for (auto _ : state) {
+      consume<C>(gen, elements_per_iteration);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements_per_iteration));
+  }
+
+  template<arithmetic T, std::size_t N>
+  coro::batch_generator<T, N> ascending_batches(const T start) {
+    for (T i = start; ; ++i) {
+      co_yield i;
+    }
+  }
+
+  template<arithmetic T>
+  void BM_ascending_batches(benchmark::State& state) {
+    constexpr std::size_t batch_size = 256;
+    constexpr std::size_t batches_per_iteration = 4;
+    auto gen = ascending_batches<T, batch_size>(T{0});
+    for (auto _ : state) {
+      for (std::size_t n = 0; n < batches_per_iteration && gen.next(); n++) {
+        for (const auto value : gen.getBatch()) {
+          benchmark::DoNotOptimize(value);
+        }
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batches_per_iteration * batch_size));
+  }
+
+  // the fill hook of ascending_sequence(), versus the per value consumption of BM_ascending_sequence
+  template<arithmetic T>
+  void BM_ascending_generate_into(benchmark::State& state) {
+    constexpr std::size_t elements_per_iteration = 1'000;
+    std::vector<T> buf(elements_per_iteration);
+    auto gen = ascending_sequence(T{0});
+    gen.next(); // the coroutine registers its hooks once it has started
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(gen.generate_into(buf));
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements_per_iteration));
+  }
+
+  // skips the argument's count of values, then consumes one - via the skip hook of ascending_sequence()
+  // (an O(1) jump for integral values) or by resuming the coroutine per value (floating point values)
+  template<arithmetic T>
+  void BM_ascending_skip(benchmark::State& state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    auto gen = ascending_sequence(T{0});
+    gen.next(); // the coroutine registers its hooks once it has started
+    for (auto _ : state) {
+      gen.skip(count);
+      gen.next();
+      benchmark::DoNotOptimize(gen.getValueRef());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * (count + 1)));
+  }
+
+  // the whole sequence per iteration, i.e., including the frame allocation
+  template<arithmetic T, consumption C>
+  void BM_fibonacci(benchmark::State& state) {
+    const auto ceiling = ceiling_of<T>();
+    int64_t items = 0;
+    for (auto _ : state) {
+      auto gen = fibonacci(ceiling);
+      consume<C>(gen, std::numeric_limits<std::size_t>::max());
+      items += fibonacci_length(ceiling);
+    }
+    state.SetItemsProcessed(items);
+  }
+
+  // the exception policies, of which terminate_on_exception stores no exception_ptr - on the path on which
+  // nothing is thrown, both are to cost the same per element, both in the steady state...
+  template<typename ExceptionPolicy, consumption C>
+  void BM_ascending_policy(benchmark::State& state) {
+    constexpr std::size_t elements_per_iteration = 1'000;
+    auto gen = ascending_sequence<unsigned long, coro::generator<unsigned long, ExceptionPolicy>>(0ul);
+    for (auto _ : state) {
+      consume<C>(gen, elements_per_iteration);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements_per_iteration));
+  }
+
+  // ...and for the whole sequence, including the frame allocation
+  template<typename ExceptionPolicy, consumption C>
+  void BM_fibonacci_policy(benchmark::State& state) {
+    const auto ceiling = ceiling_of<unsigned long>();
+    int64_t items = 0;
+    for (auto _ : state) {
+      auto gen = fibonacci<unsigned long, coro::generator<unsigned long, ExceptionPolicy>>(ceiling);
+      consume<C>(gen, std::numeric_limits<std::size_t>::max());
+      items += fibonacci_length(ceiling);
+    }
+    state.SetItemsProcessed(items);
+  }
+
+  // as above, but of the generator of fibonacci_sequence(), i.e., of a step function rather than a coroutine body
+  void BM_fibonacci_sequence(benchmark::State& state) {
+    const auto ceiling = ceiling_of<unsigned long>();
+    const auto seq = fibonacci_sequence(ceiling);
+    int64_t items = 0;
+    for (auto _ : state) {
+      auto gen = seq();
+      consume<consumption::next_get_value_ref>(gen, std::numeric_limits<std::size_t>::max());
+      items += fibonacci_length(ceiling);
+    }
+    state.SetItemsProcessed(items);
+  }
+
+  // as above, but of the table of the sequence that was evaluated at compile time (refer to constexpr_sequence.h)
+  void BM_fibonacci_table(benchmark::State& state) {
+    constexpr auto& table = coro::sequence_table<fibonacci_sequence(ceiling_of<unsigned long>())>;
+    for (auto _ : state) {
+      for (const auto& value : table) {
+        benchmark::DoNotOptimize(value);
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * table.size()));
+  }
+
+  enum class allocator { frame_pool, synchronized_pool, unsynchronized_pool, new_delete, numa_hugepage, fixed_buffer, bump_arena };
+
+  template<allocator A, typename F>
+  void with_resource(F&& f) {
+    if constexpr (A == allocator::frame_pool) {
+      f(&coro::frame_pool);
+    } else if constexpr (A == allocator::synchronized_pool) {
+      f(&coro::mem_pool);
+    } else if constexpr (A == allocator::unsynchronized_pool) {
+      std::pmr::unsynchronized_pool_resource pool{std::pmr::new_delete_resource()};
+      f(&pool);
+    } else if constexpr (A == allocator::new_delete) {
+      f(std::pmr::new_delete_resource());
+    } else if constexpr (A == allocator::numa_hugepage) {
+      static coro::numa_hugepage_resource huge_pages{}; // keeps its pages mapped across the benchmarks
+      f(&huge_pages);
+    } else {
+      // generators are created and destroyed one at a time, so a frame is recycled (LIFO)
+      alignas(std::max_align_t) static std::array<std::byte, 4096> buf;
+      if constexpr (A == allocator::fixed_buffer) {
+        coro::fixed_buffer_pmr_allocator arena{buf.data(), buf.size()};
+        f(&arena);
+      } else {
+        coro::bump_arena_pmr_allocator arena{buf.data(), buf.size()};
+        f(&arena);
+      }
+    }
+  }
+
+  template<allocator A>
+  void BM_fibonacci_alloc(benchmark::State& state) {
+    const auto ceiling = ceiling_of<unsigned long>();
+    with_resource<A>([&](std::pmr::memory_resource* mr) {
+      int64_t items = 0;
+      for (auto _ : state) {
+        auto gen = fibonacci(std::allocator_arg, mr, ceiling);
+        consume<consumption::next_get_value_ref>(gen, std::numeric_limits<std::size_t>::max());
+        items += fibonacci_length(ceiling);
+      }
+      state.SetItemsProcessed(items);
+    });
+  }
+
+  // the cost of creating, starting and destroying a generator, i.e., mostly frame allocation
+  template<allocator A>
+  void BM_generator_lifetime(benchmark::State& state) {
+    with_resource<A>([&](std::pmr::memory_resource* mr) {
+      for (auto _ : state) {
+        auto gen = ascending_sequence(std::allocator_arg, mr, 0);
+        benchmark::DoNotOptimize(gen.next());
+      }
+      state.SetItemsProcessed(state.iterations());
+    });
+  }
+
+  /**
+   * The latency of a resume (and value) as the number of live generators grows: all of
+   * state.range(0) generators are resumed once per iteration, in a shuffled order, so
+   * that once their frames outgrow the caches (and the TLB) each resume misses, and
+   * the items are the resumes. Their frames are allocated one after another, as a
+   * server that accepts many concurrent streams would.
+   */
+  template<allocator A>
+  void BM_resume_live_frames(benchmark::State& state) {
+    const auto num_frames = static_cast<std::size_t>(state.range(0));
+    with_resource<A>([&](std::pmr::memory_resource* mr) {
+      std::vector<coro::generator<int>> gens;
+      gens.reserve(num_frames);
+      for (std::size_t i = 0; i < num_frames; i++) {
+        gens.push_back(ascending_sequence(std::allocator_arg, mr, 0));
+      }
+      std::vector<std::uint32_t> order(num_frames);
+      std::iota(order.begin(), order.end(), 0u);
+      std::shuffle(order.begin(), order.end(), std::mt19937{42});
+      for (auto _ : state) {
+        for (const auto i : order) {
+          gens[i].next();
+          benchmark::DoNotOptimize(gens[i].getValueRef());
+        }
+      }
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * num_frames));
+    });
+  }
+
+  // as BM_generator_lifetime, but via the global operator new, so that the compiler may elide the frame allocation
+  void BM_generator_lifetime_elidable(benchmark::State& state) {
+    for (auto _ : state) {
+      auto gen = fibonacci<unsigned long, coro::elidable_generator<unsigned long>>(ceiling_of<unsigned long>());
+      benchmark::DoNotOptimize(gen.next());
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  // as above, but the frame of the destroyed generator is recycled by the next one (refer to frame_recycler.h)
+  void BM_generator_lifetime_reusable(benchmark::State& state) {
+    for (auto _ : state) {
+      auto gen = fibonacci<unsigned long, coro::reusable_generator<unsigned long>>(ceiling_of<unsigned long>());
+      benchmark::DoNotOptimize(gen.next());
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+  template<arithmetic T>
+  coro::async_generator<T> async_ascending_sequence(const T start) {
+    for (T i = start; ; ++i) {
+      co_yield i;
+    }
+  }
+
+  template<arithmetic T>
+  coro::task<> consume_async(coro::async_generator<T>& gen, std::size_t count) {
+    for (std::size_t i = 0; i < count && co_await gen.next(); i++) {
+      benchmark::DoNotOptimize(gen.getValueRef());
+    }
+  }
+
+  // the cost per element of co_await gen.next() when the generator body does not suspend otherwise
+  template<arithmetic T>
+  void BM_async_ascending_sequence(benchmark::State& state) {
+    constexpr std::size_t elements_per_iteration = 1'000;
+    auto gen = async_ascending_sequence(T{0});
+    for (auto _ : state) {
+      coro::sync_wait(consume_async(gen, elements_per_iteration));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements_per_iteration));
+  }
+
+  // the generator on a background thread, handed over in batches of state.range(0) values
+  void BM_prefetch(benchmark::State& state) {
+    constexpr std::size_t elements_per_iteration = 100'000;
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+      auto gen = coro::prefetch(ascending_sequence(0), 1024, batch);
+      consume<consumption::next_get_value_ref>(gen, elements_per_iteration);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements_per_iteration));
+  }
+
+  coro::generator<int> ascending_range(const int start, const int stop) {
+    for (int i = start; i < stop; i++) {
+      co_yield i;
+    }
+  }
+
+  // a generator split across state.range(0) consumer threads, round-robin
+  void BM_partition(benchmark::State& state) {
+    constexpr int elements_per_iteration = 100'000;
+    const auto num_partitions = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+      auto partitions = coro::partition(ascending_range(0, elements_per_iteration), num_partitions);
+      std::vector<std::thread> consumers;
+      for (auto& partition : partitions) {
+        consumers.emplace_back([&partition] {
+          consume<consumption::iterator>(partition, std::numeric_limits<std::size_t>::max());
+        });
+      }
+      for (auto& consumer : consumers) consumer.join();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements_per_iteration));
+  }
+
+  // state.range(0) generators merged into one, unordered (via the MPSC queue) or ordered (k-way merge)
+  template<bool Ordered>
+  void BM_merge(benchmark::State& state) {
+    constexpr int elements_per_iteration = 100'000;
+    const auto num_generators = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+      std::vector<coro::generator<int>> gens;
+      for (int i = 0; i < num_generators; i++) {
+        gens.push_back(ascending_range(i * elements_per_iteration / num_generators,
+                                       (i + 1) * elements_per_iteration / num_generators));
+      }
+      auto merged = Ordered ? coro::merge_ordered(std::move(gens)) : coro::merge(std::move(gens));
+      consume<consumption::iterator>(merged, std::numeric_limits<std::size_t>::max());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements_per_iteration));
+  }
+
+  // a generator shared by state.range(0) readers, in lockstep on one thread (null_mutex), or each on
+  // its own thread (std::mutex) - the items are the values read, i.e., elements times readers
+  template<typename Mutex>
+  void BM_tee(benchmark::State& state) {
+    constexpr int elements_per_iteration = 100'000;
+    const auto num_readers = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+      auto readers = coro::tee<Mutex>(ascending_range(0, elements_per_iteration), num_readers);
+      if constexpr (std::is_same_v<Mutex, coro::null_mutex>) {
+        for (bool more = true; more; ) {
+          for (auto& reader : readers) {
+            more = reader.next();
+            if (more) benchmark::DoNotOptimize(reader.getValueRef());
+          }
+        }
+      } else {
+        std::vector<std::thread> consumers;
+        for (auto& reader : readers) {
+          consumers.emplace_back([&reader] {
+            consume<consumption::iterator>(reader, std::numeric_limits<std::size_t>::max());
+          });
+        }
+        for (auto& consumer : consumers) consumer.join();
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements_per_iteration * num_readers));
+  }
+
+  // many independent generator-driven tasks, drained concurrently by state.range(0) workers
+  void BM_scheduler_for_each(benchmark::State& state) {
+    constexpr int tasks_per_iteration = 1'000;
+    const auto ceiling = ceiling_of<unsigned long>();
+    coro::scheduler sched{static_cast<std::size_t>(state.range(0))};
+    for (auto _ : state) {
+      for (int i = 0; i < tasks_per_iteration; i++) {
+        sched.spawn(coro::for_each(sched, fibonacci(ceiling), [](const auto& value) { benchmark::DoNotOptimize(value); }));
+      }
+      sched.wait();
+    }
+    state.SetItemsProcessed(state.iterations() * tasks_per_iteration * fibonacci_length(ceiling));
+  }
+
+  // a CPU-bound splittable sequence: the splitmix64 hash of each index, iterated
+  const coro::indexed_sequence hashed_indices{[](std::size_t index) {
+    std::uint64_t z = index;
+    for (int round = 0; round < 8; round++) {
+      z += 0x9e3779b97f4a7c15u;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+      z ^= z >> 31;
+    }
+    return z;
+  }};
+  constexpr std::size_t hashed_indices_per_iteration = 1 << 20;
+
+  // the sequence generated on the calling thread...
+  void BM_split_generate_into(benchmark::State& state) {
+    std::vector<std::uint64_t> out(hashed_indices_per_iteration);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(hashed_indices.split(0, out.size()).generate_into(out));
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * hashed_indices_per_iteration));
+  }
+
+  // ...and in pieces across state.range(0) workers of a scheduler (refer to splittable_generator.h)
+  void BM_parallel_generate_into(benchmark::State& state) {
+    coro::scheduler sched{static_cast<std::size_t>(state.range(0))};
+    std::vector<std::uint64_t> out(hashed_indices_per_iteration);
+    for (auto _ : state) {
+      coro::parallel_generate_into(sched, hashed_indices, 0, std::span{out});
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * hashed_indices_per_iteration));
+  }
+
+  // ...and consumed in order, whilst the pieces that follow are generated ahead on the workers
+  void BM_parallel_sequence(benchmark::State& state) {
+    coro::scheduler sched{static_cast<std::size_t>(state.range(0))};
+    for (auto _ : state) {
+      auto gen = coro::parallel_sequence(sched, hashed_indices, 0, hashed_indices_per_iteration);
+      consume<consumption::next_get_value_ref>(gen, std::numeric_limits<std::size_t>::max());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * hashed_indices_per_iteration));
+  }
+
+  // a 16 MiB log-like file of 80 character lines (created once, in the temp directory)
+  const std::filesystem::path& lines_file() {
+    static const auto path = [] {
+      auto p = std::filesystem::temp_directory_path() / "coro_bench_lines.txt";
+      std::ofstream out{p, std::ios::binary | std::ios::trunc};
+      const std::string line(79, 'x');
+      for (std::size_t i = 0; i < (std::size_t{16} << 20) / 80; i++) {
+        out << line << '\n';
+      }
+      return p;
+    }();
+    return path;
+  }
+
+  void BM_read_lines(benchmark::State& state) {
+    const auto& path = lines_file();
+    int64_t bytes = 0;
+    for (auto _ : state) {
+      for (const auto line : coro::read_lines(path)) {
+        benchmark::DoNotOptimize(line.data());
+        bytes += static_cast<int64_t>(line.size()) + 1;
+      }
+    }
+    state.SetBytesProcessed(bytes);
+  }
+
+  constexpr int sink_values = 1 << 16;
+
+  // the values of a generator appended to a vector one at a time...
+  void BM_push_back_loop(benchmark::State& state) {
+    for (auto _ : state) {
+      std::vector<int> values;
+      for (auto gen = ascending_range(0, sink_values); gen.next(); ) {
+        values.push_back(gen.getValueRef());
+      }
+      benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * sink_values));
+  }
+
+  // ...and via coro::to_vector(), with a capacity hint (refer to sink.h)
+  void BM_to_vector(benchmark::State& state) {
+    for (auto _ : state) {
+      auto values = coro::to_vector(ascending_range(0, sink_values), sink_values);
+      benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * sink_values));
+  }
+
+  // the values of a generator written as lines of text to /dev/null via an ostream, as the demo program prints...
+  void BM_write_ostream(benchmark::State& state) {
+    std::ofstream out{"/dev/null"};
+    for (auto _ : state) {
+      for (auto gen = ascending_range(0, sink_values); gen.next(); ) {
+        out << gen.getValueRef() << '\n';
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * sink_values));
+  }
+
+  // ...and via coro::to_file(), one write syscall per 64 KiB
+  void BM_to_file(benchmark::State& state) {
+    const coro::detail::file_descriptor out{"/dev/null", O_WRONLY | O_CLOEXEC};
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(coro::to_file(ascending_range(0, sink_values), out.get()));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * sink_values));
+  }
+
+  // source, filter, map and take_while stages
+  constexpr int pipeline_ceiling = 3'000;
+  constexpr auto not_multiple_of_3 = [](int v) { return v % 3 != 0; };
+  constexpr auto twice = [](int v) { return v * 2; };
+  constexpr auto below_ceiling = [](int v) { return v < pipeline_ceiling; };
+
+  template<typename P>
+  coro::generator<int> filter_stage(coro::generator<int> src, P pred) {
+    for (auto& v : src) {
+      if (pred(v)) co_yield v;
+    }
+  }
+
+  template<typename F>
+  coro::generator<int> map_stage(coro::generator<int> src, F f) {
+    for (auto& v : src) {
+      co_yield f(v);
+    }
+  }
+
+  template<typename P>
+  coro::generator<int> take_while_stage(coro::generator<int> src, P pred) {
+    for (auto& v : src) {
+      if (!pred(v)) break;
+      co_yield v;
+    }
+  }
+
+  // a generator per stage, i.e., a frame per stage and a resume per stage per element
+  void BM_pipeline_chained(benchmark::State& state) {
+    int64_t items = 0;
+    for (auto _ : state) {
+      auto rng = take_while_stage(map_stage(filter_stage(ascending_sequence(0), not_multiple_of_3), twice), below_ceiling);
+      for (const auto v : rng) {
+        benchmark::DoNotOptimize(v);
+        items++;
+      }
+    }
+    state.SetItemsProcessed(items);
+  }
+
+  // the stages fused into the consumer's loop, i.e., one frame and one resume per element
+  void BM_pipeline_fused(benchmark::State& state) {
+    int64_t items = 0;
+    for (auto _ : state) {
+      auto rng = ascending_sequence(0) | coro::views::filter(not_multiple_of_3) | coro::views::map(twice)
+                                       | coro::views::take_while(below_ceiling);
+      for (const auto v : rng) {
+        benchmark::DoNotOptimize(v);
+        items++;
+      }
+    }
+    state.SetItemsProcessed(items);
+  }
+
+  // the fused stages with capturing lambdas, composed further with std::views::take
+  void BM_pipeline_std_views(benchmark::State& state) {
+    const int divisor = 3;
+    const int factor = 2;
+    constexpr int count = 2'000;
+    int64_t items = 0;
+    for (auto _ : state) {
+      auto fused = ascending_sequence(0) | coro::views::filter([divisor](int v) { return v % divisor != 0; })
+                                         | coro::views::map([factor](int v) { return v * factor; });
+      static_assert(std::ranges::view<decltype(fused)>);
+      auto rng = std::move(fused) | std::views::take(count);
+      static_assert(std::ranges::view<decltype(rng)>);
+      for (const auto v : rng) {
+        benchmark::DoNotOptimize(v);
+        items++;
+      }
+    }
+    if (items != static_cast<int64_t>(state.iterations() * count)) state.SkipWithError("too few values taken");
+    state.SetItemsProcessed(items);
+  }
+
+} // namespace
+
+#define CORO_BENCH_CONSUMPTION(BM, T)                                       \
+  BENCHMARK_TEMPLATE(BM, T, consumption::next_get_value);                   \
+  BENCHMARK_TEMPLATE(BM, T, consumption::next_get_value_ref);               \
+  BENCHMARK_TEMPLATE(BM, T, consumption::iterator);                         \
+  BENCHMARK_TEMPLATE(BM, T, consumption::ranges_for_each)
+
+CORO_BENCH_CONSUMPTION(BM_ascending_sequence, int);
+CORO_BENCH_CONSUMPTION(BM_ascending_sequence, unsigned long);
+CORO_BENCH_CONSUMPTION(BM_ascending_sequence, double);
+CORO_BENCH_CONSUMPTION(BM_ascending_sequence, long double);
+
+BENCHMARK_TEMPLATE(BM_ascending_batches, int);
+BENCHMARK_TEMPLATE(BM_ascending_batches, unsigned long);
+BENCHMARK_TEMPLATE(BM_ascending_batches, double);
+BENCHMARK_TEMPLATE(BM_ascending_batches, long double);
+
+BENCHMARK_TEMPLATE(BM_ascending_generate_into, int);
+BENCHMARK_TEMPLATE(BM_ascending_generate_into, unsigned long);
+BENCHMARK_TEMPLATE(BM_ascending_generate_into, double);
+
+BENCHMARK_TEMPLATE(BM_ascending_skip, int)->Arg(1'000);
+BENCHMARK_TEMPLATE(BM_ascending_skip, double)->Arg(1'000);
+
+BENCHMARK_TEMPLATE(BM_async_ascending_sequence, int);
+BENCHMARK_TEMPLATE(BM_async_ascending_sequence, double);
+
+CORO_BENCH_CONSUMPTION(BM_fibonacci, int);
+CORO_BENCH_CONSUMPTION(BM_fibonacci, unsigned long);
+CORO_BENCH_CONSUMPTION(BM_fibonacci, double);
+CORO_BENCH_CONSUMPTION(BM_fibonacci, long double);
+BENCHMARK(BM_fibonacci_sequence);
+BENCHMARK(BM_fibonacci_table);
+
+#define CORO_BENCH_EXCEPTION_POLICY(BM)                                                        \
+  BENCHMARK_TEMPLATE(BM, coro::propagate_exceptions, consumption::next_get_value_ref);         \
+  BENCHMARK_TEMPLATE(BM, coro::terminate_on_exception, consumption::next_get_value_ref);       \
+  BENCHMARK_TEMPLATE(BM, coro::propagate_exceptions, consumption::iterator);                   \
+  BENCHMARK_TEMPLATE(BM, coro::terminate_on_exception, consumption::iterator)
+
+CORO_BENCH_EXCEPTION_POLICY(BM_ascending_policy);
+CORO_BENCH_EXCEPTION_POLICY(BM_fibonacci_policy);
+
+#define CORO_BENCH_ALLOCATOR(BM)                                            \
+  BENCHMARK_TEMPLATE(BM, allocator::frame_pool);                            \
+  BENCHMARK_TEMPLATE(BM, allocator::synchronized_pool);                     \
+  BENCHMARK_TEMPLATE(BM, allocator::unsynchronized_pool);                   \
+  BENCHMARK_TEMPLATE(BM, allocator::new_delete);                            \
+  BENCHMARK_TEMPLATE(BM, allocator::numa_hugepage);                         \
+  BENCHMARK_TEMPLATE(BM, allocator::fixed_buffer);                          \
+  BENCHMARK_TEMPLATE(BM, allocator::bump_arena)
+
+CORO_BENCH_ALLOCATOR(BM_fibonacci_alloc);
+CORO_BENCH_ALLOCATOR(BM_generator_lifetime);
+#define CORO_BENCH_LIVE_FRAMES(A) \
+  BENCHMARK_TEMPLATE(BM_resume_live_frames, A)->RangeMultiplier(8)->Range(1 << 9, 1 << 18)
+CORO_BENCH_LIVE_FRAMES(allocator::frame_pool);
+CORO_BENCH_LIVE_FRAMES(allocator::synchronized_pool);
+CORO_BENCH_LIVE_FRAMES(allocator::new_delete);
+CORO_BENCH_LIVE_FRAMES(allocator::numa_hugepage);
+BENCHMARK(BM_generator_lifetime_elidable);
+BENCHMARK(BM_generator_lifetime_reusable);
+
+BENCHMARK(BM_pipeline_chained);
+BENCHMARK(BM_pipeline_fused);
+BENCHMARK(BM_pipeline_std_views);
+
+BENCHMARK(BM_read_lines);
+
+BENCHMARK(BM_push_back_loop);
+BENCHMARK(BM_to_vector);
+BENCHMARK(BM_write_ostream);
+BENCHMARK(BM_to_file);
+
+BENCHMARK(BM_prefetch)->Arg(1)->Arg(16)->Arg(64)->Arg(256)->UseRealTime();
+BENCHMARK(BM_partition)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_merge, false)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_merge, true)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_tee, coro::null_mutex)->Arg(2)->Arg(4);
+BENCHMARK_TEMPLATE(BM_tee, std::mutex)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK(BM_scheduler_for_each)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+BENCHMARK(BM_split_generate_into)->UseRealTime();
+BENCHMARK(BM_parallel_generate_into)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK(BM_parallel_sequence)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,224 @@
+/** coro_stress.cpp
+ *
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Licensed under the MIT License - refer to LICENSE project document.
+ *
+ * Stress test of the pmr memory resources of coroutine frames at scale: per
+ * resource, millions of ascending_sequence() generators are created (and started)
+ * across several threads, so that all of them are suspended at once; each thread
+ * then hands its generators over to the next thread, which resumes each of them
+ * once (in a shuffled order, timing every resume) and finally destroys them - i.e.,
+ * every frame is resumed and freed on a thread other than the one it was allocated
+ * on. Reports the throughput of each phase, the resident set size whilst all the
+ * generators are live, and the p50/p99/p999 latency of a resume.
+ *
+ * The resources that are not thread-safe (std::pmr::unsynchronized_pool_resource
+ * and coro::fixed_buffer_pmr_allocator) are serialized by a mutex, which is then
+ * what their figures measure. The RSS figures are the growth of the resident set
+ * over its size before the resource's phases, so memory that an earlier resource
+ * retained and a later one reuses is not counted twice. Exits with a non-zero
+ * status should any generator have resumed to a value other than the one expected.
+ *
+ * Usage: coro_stress [num_generators (default 1000000)] [num_threads (default max(2, CPUs))]
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "frame_pool.h"
+#include "generator.h"
+#include "numa_frame_resource.h"
+#include "sequences.h"
+
+using stress_clock = std::chrono::steady_clock;
+
+// serializes a memory resource that is not thread-safe
+class locked_resource : public std::pmr::memory_resource {
+private:
+  std::pmr::memory_resource* const resource;
+  std::mutex mtx;
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    std::lock_guard<std::mutex> lk{mtx};
+    return resource->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    std::lock_guard<std::mutex> lk{mtx};
+    resource->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+public:
+  explicit locked_resource(std::pmr::memory_resource* r) noexcept : resource{r} {}
+};
+
+// the resident set size of the process, per /proc/self/statm
+static std::size_t resident_bytes() {
+  std::ifstream statm{"/proc/self/statm"};
+  std::size_t total_pages = 0;
+  std::size_t resident_pages = 0;
+  statm >> total_pages >> resident_pages;
+  return resident_pages * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+static double seconds_since(stress_clock::time_point start) {
+  return std::chrono::duration<double>(stress_clock::now() - start).count();
+}
+
+// runs f(k) on each of num_threads threads, and returns the wall-clock seconds until all of them completed
+template<typename F>
+static double run_threads(std::size_t num_threads, F f) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  const auto start = stress_clock::now();
+  for (std::size_t k = 0; k < num_threads; k++) {
+    threads.emplace_back(f, k);
+  }
+  for (auto& t : threads) t.join();
+  return seconds_since(start);
+}
+
+// the cost of reading the clock, which each of the resume latencies includes
+static std::int64_t timer_overhead_ns() {
+  constexpr int samples = 100'000;
+  auto least = stress_clock::duration::max();
+  for (int i = 0; i < samples; i++) {
+    const auto t0 = stress_clock::now();
+    const auto t1 = stress_clock::now();
+    least = std::min(least, t1 - t0);
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(least).count();
+}
+
+static std::int64_t percentile(std::vector<std::int64_t>& samples, double p) {
+  if (samples.empty()) return 0;
+  const auto k = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(k), samples.end());
+  return samples[k];
+}
+
+/**
+ * Runs the create, hand over and resume, and destroy phases with the frames of all
+ * the generators allocated from mr, and prints a row of the results.
+ *
+ * @return the number of generators that resumed to an unexpected value
+ */
+static std::size_t stress(const char* name, std::pmr::memory_resource* mr, std::size_t num_generators,
+                          std::size_t num_threads) {
+  using generator_type = coro::generator<int>;
+  const auto per_thread = num_generators / num_threads;
+  std::vector<std::vector<generator_type>> generators(num_threads);
+  std::vector<std::vector<std::int64_t>> latencies(num_threads);
+  std::atomic<std::size_t> failures{0};
+  const auto rss_before = resident_bytes();
+
+  // each thread creates and starts its own generators, all of which stay suspended
+  const auto create_secs = run_threads(num_threads, [&](std::size_t k) {
+    auto& gens = generators[k];
+    gens.reserve(per_thread);
+    for (std::size_t i = 0; i < per_thread; i++) {
+      const auto start = static_cast<int>(k * per_thread + i);
+      gens.push_back(ascending_sequence(std::allocator_arg, mr, start));
+      if (!gens.back().next() || gens.back().getValueRef() != start) failures++;
+    }
+  });
+  const auto rss_live = resident_bytes();
+
+  // each thread takes over the generators of the next thread, and resumes each of them once
+  std::vector<std::vector<generator_type>> handed_over(num_threads);
+  const auto resume_secs = run_threads(num_threads, [&](std::size_t k) {
+    auto& gens = handed_over[k] = std::move(generators[(k + 1) % num_threads]);
+    std::vector<std::uint32_t> order(gens.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::shuffle(order.begin(), order.end(), std::mt19937{static_cast<std::uint32_t>(k)});
+    auto& samples = latencies[k];
+    samples.reserve(gens.size());
+    const auto first = static_cast<int>(((k + 1) % num_threads) * per_thread);
+    for (const auto i : order) {
+      const auto t0 = stress_clock::now();
+      const bool ok = gens[i].next();
+      const auto t1 = stress_clock::now();
+      samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+      if (!ok || gens[i].getValueRef() != first + static_cast<int>(i) + 1) failures++;
+    }
+  });
+
+  // and destroys them, i.e., frees each frame on a thread other than the one that allocated it
+  const auto destroy_secs = run_threads(num_threads, [&](std::size_t k) {
+    handed_over[k].clear();
+    handed_over[k].shrink_to_fit();
+  });
+  const auto rss_after = resident_bytes();
+
+  std::vector<std::int64_t> all;
+  all.reserve(per_thread * num_threads);
+  for (auto& samples : latencies) all.insert(all.end(), samples.begin(), samples.end());
+  const auto total = static_cast<double>(per_thread * num_threads);
+  const auto mib = [](std::size_t bytes_after, std::size_t bytes_before) {
+    return (static_cast<double>(bytes_after) - static_cast<double>(bytes_before)) / (1024.0 * 1024.0);
+  };
+  std::printf("%-36s %9.2f %9.2f %9.2f %9.1f %9.1f %7lld %7lld %7lld\n", name,
+              total / create_secs / 1e6, total / resume_secs / 1e6, total / destroy_secs / 1e6,
+              mib(rss_live, rss_before), mib(rss_after, rss_before),
+              static_cast<long long>(percentile(all, 0.50)), static_cast<long long>(percentile(all, 0.99)),
+              static_cast<long long>(percentile(all, 0.999)));
+  std::fflush(stdout);
+  return failures.load();
+}
+
+int main(int argc, char* argv[]) {
+  const std::size_t num_generators = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+  const std::size_t num_threads = argc > 2 ? std::max<std::size_t>(1, std::strtoull(argv[2], nullptr, 10))
+                                           : std::max(2u, std::thread::hardware_concurrency());
+  std::printf("%zu live generators across %zu threads, each resumed and destroyed on a foreign thread; "
+              "timer overhead %lld ns per resume\n",
+              num_generators / num_threads * num_threads, num_threads, static_cast<long long>(timer_overhead_ns()));
+  std::printf("%-36s %9s %9s %9s %9s %9s %7s %7s %7s\n", "resource", "create", "resume", "destroy",
+              "live RSS", "after", "p50", "p99", "p999");
+  std::printf("%-36s %9s %9s %9s %9s %9s %7s %7s %7s\n", "", "(Mops/s)", "(Mops/s)", "(Mops/s)",
+              "(MiB)", "(MiB)", "(ns)", "(ns)", "(ns)");
+
+  std::size_t failures = 0;
+  failures += stress("coro::frame_pool", &coro::frame_pool, num_generators, num_threads);
+  {
+    std::pmr::synchronized_pool_resource pool{std::pmr::new_delete_resource()};
+    failures += stress("synchronized_pool_resource", &pool, num_generators, num_threads);
+  }
+  {
+    std::pmr::unsynchronized_pool_resource pool{std::pmr::new_delete_resource()};
+    locked_resource locked{&pool};
+    failures += stress("unsynchronized_pool_resource+mutex", &locked, num_generators, num_threads);
+  }
+  failures += stress("new_delete_resource", std::pmr::new_delete_resource(), num_generators, num_threads);
+  {
+    coro::numa_hugepage_resource huge_pages;
+    failures += stress("coro::numa_hugepage_resource", &huge_pages, num_generators, num_threads);
+  }
+  {
+    // sized to fit all the frames, as the buffer has no upstream resource to fall back to
+    const std::size_t buf_size = num_generators * 256;
+    const auto buf = std::make_unique_for_overwrite<std::byte[]>(buf_size);
+    coro::fixed_buffer_pmr_allocator arena{buf.get(), buf_size};
+    locked_resource locked{&arena};
+    failures += stress("fixed_buffer_pmr_allocator+mutex", &locked, num_generators, num_threads);
+  }
+
+  if (failures > 0) {
+    std::printf("FAILED: %zu generator(s) resumed to an unexpected value\n", failures);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,306 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Fan-out and fan-in of generators across threads:
+ *
+ * partition()     - splits one generator into N generators (one per worker thread),
+ *                   round-robin or by the hash of a key of each value
+ * merge()         - turns N generators into one, running each on its own thread and
+ *                   yielding their values in order of arrival (via an MPSC queue)
+ * merge_ordered() - turns N sorted generators into one sorted generator (k-way merge)
+ */
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <assert.h>
+#include "channel.h"
+#include "generator.h"
+
+namespace coro {
+
+  // partitions values in turn across the partitions
+  struct round_robin {
+    std::size_t next = 0;
+    template<typename T>
+    std::size_t operator()(const T&, std::size_t num_partitions) noexcept {
+      const auto k = next;
+      next = next + 1 == num_partitions ? 0 : next + 1;
+      return k;
+    }
+  };
+
+  // partitions values by the (std::hash) hash of their key, so that equal keys go to the same partition
+  template<typename KeyFn = std::identity>
+  struct by_key {
+    [[no_unique_address]] KeyFn key{};
+    template<typename T>
+    std::size_t operator()(const T& value, std::size_t num_partitions) const {
+      using key_type = std::remove_cvref_t<std::invoke_result_t<const KeyFn&, const T&>>;
+      return std::hash<key_type>{}(std::invoke(key, value)) % num_partitions;
+    }
+  };
+  template<typename KeyFn>
+  by_key(KeyFn) -> by_key<KeyFn>;
+
+  template<typename P, typename T>
+  concept partitioner = std::invocable<P&, const T&, std::size_t>
+      && std::convertible_to<std::invoke_result_t<P&, const T&, std::size_t>, std::size_t>;
+
+  namespace detail {
+
+    // copies the value into a channel, or moves it for a move-only type (whose value can only be consumed by moving)
+    template<typename Channel, typename V>
+    bool push_yielded(Channel& channel, V& value) {
+      if constexpr (std::copy_constructible<std::remove_cv_t<V>>) {
+        return channel.push(std::as_const(value));
+      } else {
+        return channel.push(std::move(value));
+      }
+    }
+
+    // shared by the partitions of a generator, which the last partition to be destroyed destroys
+    template<typename G, typename P>
+    class partition_state {
+    public:
+      using value_type = typename G::value_type;
+    private:
+      G source;
+      P part;
+      std::vector<std::unique_ptr<spsc_channel<value_type>>> channels;
+      std::stop_source stop; // bound to the source
+      std::thread distributor;
+
+      void distribute() {
+        std::vector<bool> abandoned(channels.size(), false);
+        std::size_t num_abandoned = 0;
+        try {
+          for (auto itr = source.begin(); itr != source.end() && num_abandoned < channels.size(); ++itr) {
+            const std::size_t k = std::invoke(part, std::as_const(*itr), channels.size());
+            if (!abandoned[k] && !push_yielded(*channels[k], *itr)) {
+              abandoned[k] = true; // the partition's consumer was destroyed, so its values are dropped
+              num_abandoned++;
+            }
+          }
+          for (auto& ch : channels) ch->close();
+        } catch (...) {
+          const auto ex = std::current_exception();
+          for (auto& ch : channels) ch->close(ex);
+        }
+      }
+    public:
+      partition_state(G&& gen, std::size_t n, P p, std::size_t depth, std::size_t batch)
+        : source{std::move(gen)}, part{std::move(p)} {
+        source.set_stop_token(stop.get_token());
+        channels.reserve(n);
+        for (std::size_t k = 0; k < n; k++) {
+          channels.push_back(std::make_unique<spsc_channel<value_type>>(depth, batch));
+        }
+        distributor = std::thread{&partition_state::distribute, this};
+      }
+      partition_state(const partition_state&) = delete;
+      partition_state& operator=(const partition_state&) = delete;
+      ~partition_state() {
+        stop.request_stop(); // in case the source still computes a value that no partition will read
+        distributor.join();  // each partition has been drained or cancelled by now
+      }
+      spsc_channel<value_type>& channel(std::size_t k) noexcept { return *channels[k]; }
+    };
+
+    /**
+     * A partition's share of the partition_state, which cancels the partition's channel
+     * (unless drained) when its generator is destroyed - even if it never started.
+     */
+    template<typename G, typename P>
+    class partition_lease {
+    private:
+      std::shared_ptr<partition_state<G, P>> state;
+      std::size_t k;
+    public:
+      bool drained = false;
+      partition_lease(std::shared_ptr<partition_state<G, P>> s, std::size_t partition) noexcept
+        : state{std::move(s)}, k{partition} {}
+      partition_lease(partition_lease&&) noexcept = default;
+      partition_lease& operator=(partition_lease&&) = delete;
+      ~partition_lease() {
+        if (state && !drained) state->channel(k).cancel();
+      }
+      auto& channel() const noexcept { return state->channel(k); }
+    };
+
+    template<typename G, typename P>
+    generator<typename G::value_type> partition_stream(partition_lease<G, P> lease) {
+      auto& channel = lease.channel();
+      while (auto value = channel.front()) {
+        co_yield *value;
+        channel.pop();
+      }
+      lease.drained = true;
+      channel.rethrow_if_exception();
+    }
+
+    /**
+     * The producer threads of merge(), which are stopped (via the stop token bound to
+     * the generators they run, and via the queue) and joined when the consumer abandons it.
+     */
+    template<typename T>
+    class merge_workers {
+    private:
+      mpsc_channel<T>& queue;
+      std::stop_source stop;
+      std::vector<std::thread> threads;
+    public:
+      merge_workers(mpsc_channel<T>& q, std::stop_source s) noexcept : queue{q}, stop{std::move(s)} {}
+      merge_workers(const merge_workers&) = delete;
+      merge_workers& operator=(const merge_workers&) = delete;
+      ~merge_workers() {
+        stop.request_stop();
+        queue.cancel();
+        while (queue.front() != nullptr) { // unblocks the producers until they have all closed the queue
+          queue.pop();
+        }
+        for (auto& t : threads) t.join();
+      }
+      template<typename F>
+      void spawn(F&& f) {
+        threads.emplace_back(std::forward<F>(f));
+      }
+    };
+
+  } // namespace detail
+
+  /**
+   * Splits the generator into num_partitions generators, each of which can be
+   * iterated on its own (worker) thread. A background thread iterates the source
+   * generator and distributes its values, as chosen by the partitioner, across
+   * bounded SPSC rings (refer to spsc_channel), one per partition. A partition that
+   * falls behind eventually stalls the others, i.e., memory use is bounded.
+   *
+   * An exception escaping the source generator is rethrown to each of the partitions
+   * after the values that preceded it. A partition that is destroyed before it has
+   * been drained drops its remaining values. The background thread is joined once all
+   * the partitions have been destroyed, and the token bound to the source generator
+   * (refer to set_stop_token()) is then stopped, in case it is still computing values.
+   *
+   * @param gen the generator to partition
+   * @param num_partitions the number of partitions (and returned generators)
+   * @param part chooses the partition of each value, e.g., round_robin{} or by_key{key_fn}
+   * @param depth the capacity of the ring of each partition
+   * @param batch the number of values per hand-over to a partition (refer to spsc_channel)
+   * @return the generator of each partition
+   */
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy,
+           partitioner<std::remove_cv_t<T>> P = round_robin>
+  std::vector<generator<std::remove_cv_t<T>>> partition(generator<T, ExceptionPolicy, AllocationPolicy> gen,
+                                                        std::size_t num_partitions, P part = {},
+                                                        std::size_t depth = 1024, std::size_t batch = 64) {
+    assert(num_partitions > 0);
+    using state_type = detail::partition_state<generator<T, ExceptionPolicy, AllocationPolicy>, P>;
+    auto state = std::make_shared<state_type>(std::move(gen), num_partitions, std::move(part), depth, batch);
+    std::vector<generator<std::remove_cv_t<T>>> partitions;
+    partitions.reserve(num_partitions);
+    for (std::size_t k = 0; k < num_partitions; k++) {
+      partitions.push_back(detail::partition_stream(detail::partition_lease{state, k}));
+    }
+    return partitions;
+  }
+
+  /**
+   * Merges the generators into one, which yields their values in order of arrival:
+   * each generator runs on its own thread, feeding a bounded MPSC queue (refer to
+   * mpsc_channel) that the returned generator drains on the consumer's thread.
+   *
+   * The first exception to escape any of the generators is rethrown to the consumer
+   * once the others have completed and all their values have been delivered.
+   * Destroying the returned generator stops (and joins) the threads, and stops the
+   * token bound to each of the generators (refer to set_stop_token()) - as does a stop
+   * requested of the token bound to the returned generator.
+   *
+   * @param gens the generators to merge
+   * @param depth the capacity of the queue
+   * @return coroutine task iterator
+   */
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy>
+  generator<std::remove_cv_t<T>> merge(std::vector<generator<T, ExceptionPolicy, AllocationPolicy>> gens,
+                                       std::size_t depth = 1024) {
+    using value_type = std::remove_cv_t<T>;
+    // not a local of the coroutine, as the frame is not allocated cache-line aligned
+    const auto queue_ptr = std::make_unique<mpsc_channel<value_type>>(depth, gens.size());
+    auto& queue = *queue_ptr;
+    std::stop_source upstream;
+    const auto stop = co_await this_stop_token(); // (a local, as g++ 12 destroys the result twice if passed on directly)
+    const std::stop_callback propagate{stop, [upstream]() mutable noexcept { upstream.request_stop(); }};
+    detail::merge_workers<value_type> workers{queue, upstream};
+    for (auto& gen : gens) {
+      gen.set_stop_token(upstream.get_token());
+      workers.spawn([&queue, &gen] {
+        try {
+          for (auto itr = gen.begin(); itr != gen.end(); ++itr) {
+            if (!detail::push_yielded(queue, *itr)) break; // the consumer abandoned the merge
+          }
+          queue.close();
+        } catch (...) {
+          queue.close(std::current_exception());
+        }
+      });
+    }
+    while (auto value = queue.front()) {
+      co_yield *value;
+      queue.pop();
+    }
+    queue.rethrow_if_exception();
+  }
+
+  /**
+   * Merges generators whose values are each sorted (per comp) into one sorted
+   * generator, on the consumer's thread: a k-way merge that yields a reference to the
+   * current value of the generator whose value is least. To also run the generators
+   * concurrently, wrap each of them with prefetch() (refer to prefetch.h) first. The
+   * token bound to the returned generator is bound to each of the generators, too.
+   *
+   * @param gens the generators to merge
+   * @param comp the ordering of the values (ties are resolved in favour of the earlier generator)
+   * @return coroutine task iterator
+   */
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy, typename Compare = std::less<>>
+  generator<std::remove_cv_t<T>> merge_ordered(std::vector<generator<T, ExceptionPolicy, AllocationPolicy>> gens,
+                                               Compare comp = {}) {
+    const auto stop = co_await this_stop_token();
+    for (auto& gen : gens) gen.set_stop_token(stop);
+    // a min-heap of the indices of the generators that have a current value
+    std::vector<std::size_t> heap;
+    heap.reserve(gens.size());
+    for (std::size_t i = 0; i < gens.size(); i++) {
+      if (gens[i].next()) heap.push_back(i);
+    }
+    const auto greater = [&gens, &comp](std::size_t a, std::size_t b) {
+      const auto& va = gens[a].getValueRef();
+      const auto& vb = gens[b].getValueRef();
+      return std::invoke(comp, vb, va) || (!std::invoke(comp, va, vb) && b < a);
+    };
+    std::make_heap(heap.begin(), heap.end(), greater);
+    while (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), greater);
+      const auto i = heap.back();
+      co_yield gens[i].getValueRef();
+      if (gens[i].next()) {
+        std::push_heap(heap.begin(), heap.end(), greater);
+      } else {
+        heap.pop_back();
+      }
+    }
+  }
+
+} // namespace coro
+
+#endif //FANOUT_H
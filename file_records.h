@@ -0,0 +1,186 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * The read_records() and read_lines() generator functions, which yield each
+ * delimited record of a file as a std::string_view, without any per-record
+ * allocation or copying.
+ *
+ * A regular file is memory mapped (with MADV_SEQUENTIAL) and the records are
+ * yielded as views into the mapping. The file is processed in windows: while the
+ * consumer works through one window, the pages of the next window are already
+ * being read ahead (MADV_WILLNEED), and the pages of the window before are
+ * released (MADV_DONTNEED), so that memory use stays bounded for large files.
+ *
+ * Files that cannot be mapped (pipes, character devices, procfs files, etc.) are
+ * read() into a buffer that is reused for the whole file; a record is only ever
+ * moved within it when it straddles the end of the data read so far.
+ *
+ * The views remain valid until the generator is resumed.
+ */
+#ifndef FILE_RECORDS_H
+#define FILE_RECORDS_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "generator.h"
+
+namespace coro {
+
+  namespace detail {
+
+    [[noreturn]] inline void throw_file_error(const char* what, const std::filesystem::path& path) {
+      const int error = errno; // before the message is built, which may allocate (and so overwrite errno)
+      throw std::system_error(error, std::generic_category(), std::string{what} + ' ' + path.string());
+    }
+
+    class file_descriptor {
+    private:
+      int fd;
+    public:
+      explicit file_descriptor(const std::filesystem::path& path, int flags = O_RDONLY | O_CLOEXEC, mode_t mode = 0)
+        : fd{::open(path.c_str(), flags, mode)} {
+        if (fd < 0) throw_file_error("open", path);
+      }
+      file_descriptor(const file_descriptor&) = delete;
+      file_descriptor& operator=(const file_descriptor&) = delete;
+      ~file_descriptor() {
+        ::close(fd);
+      }
+      int get() const noexcept { return fd; }
+    };
+
+    class file_mapping {
+    private:
+      void* addr;
+      std::size_t length;
+    public:
+      // an empty mapping is not mapped at all
+      file_mapping(const file_descriptor& fd, std::size_t len)
+        : addr{len > 0 ? ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd.get(), 0) : MAP_FAILED}, length{len} {}
+      file_mapping(const file_mapping&) = delete;
+      file_mapping& operator=(const file_mapping&) = delete;
+      ~file_mapping() {
+        if (addr != MAP_FAILED) ::munmap(addr, length);
+      }
+      bool mapped() const noexcept { return addr != MAP_FAILED; }
+      const char* data() const noexcept { return static_cast<const char*>(addr); }
+      // advice on a page-aligned sub-range (advice is only a hint, so failure is ignored)
+      void advise(std::size_t offset, std::size_t len, int advice) const noexcept {
+        if (offset < length) {
+          ::madvise(static_cast<char*>(addr) + offset, std::min(len, length - offset), advice);
+        }
+      }
+    };
+
+    // windows are a whole number of (huge) pages, so that madvise() can apply to them
+    inline constexpr std::size_t record_window_size = std::size_t{4} << 20;
+    inline constexpr std::size_t record_buffer_size = std::size_t{64} << 10;
+
+  } // namespace detail
+
+  /**
+   * Yields each record of the file that is terminated by the specified delimiter
+   * (the delimiter is not part of the record); a final record that lacks the
+   * delimiter is yielded too. Each std::string_view remains valid until the
+   * generator is resumed.
+   *
+   * Errors opening, mapping or reading the file are thrown to the consumer (from
+   * next() or from incrementing the iterator) as std::system_error.
+   *
+   * @param mr pmr memory_resource that the coroutine frame is allocated from
+   * @param path file to read
+   * @param delim record delimiter
+   * @return coroutine task iterator
+   */
+  inline generator<std::string_view> read_records(std::allocator_arg_t, std::pmr::memory_resource* mr,
+                                                  std::filesystem::path path, char delim = '\n') {
+    detail::file_descriptor fd{path};
+    struct stat st{};
+    if (::fstat(fd.get(), &st) != 0) detail::throw_file_error("stat", path);
+
+    const auto file_size = static_cast<std::size_t>(st.st_size);
+    detail::file_mapping mapping{fd, S_ISREG(st.st_mode) ? file_size : 0};
+    if (mapping.mapped()) {
+      mapping.advise(0, file_size, MADV_SEQUENTIAL);
+      mapping.advise(0, detail::record_window_size, MADV_WILLNEED);
+      const char* const data = mapping.data();
+      std::size_t pos = 0;
+      for (std::size_t window = 0; window < file_size; window += detail::record_window_size) {
+        const auto window_end = std::min(window + detail::record_window_size, file_size);
+        mapping.advise(window + detail::record_window_size, detail::record_window_size, MADV_WILLNEED);
+        while (pos < window_end) {
+          const auto found = static_cast<const char*>(std::memchr(data + pos, delim, file_size - pos));
+          const auto end = found != nullptr ? static_cast<std::size_t>(found - data) : file_size;
+          std::string_view record{data + pos, end - pos};
+          pos = end + 1;
+          co_yield record;
+        }
+        if (window >= detail::record_window_size) { // the record that ends a window may start in the window before
+          mapping.advise(window - detail::record_window_size, detail::record_window_size, MADV_DONTNEED);
+        }
+      }
+      co_return;
+    }
+
+    // not mappable - read into a buffer reused for the whole file
+    ::posix_fadvise(fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    std::vector<char> buf(detail::record_buffer_size);
+    std::size_t begin = 0; // of the first record not yielded yet
+    std::size_t end = 0;   // of the data read so far
+    for (bool eof = false; !eof; ) {
+      if (begin > 0) { // move the partial record to the front of the buffer
+        std::memmove(buf.data(), buf.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+      }
+      if (end == buf.size()) {
+        buf.resize(buf.size() * 2); // a record longer than the buffer
+      }
+      const auto n = ::read(fd.get(), buf.data() + end, buf.size() - end);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        detail::throw_file_error("read", path);
+      }
+      eof = n == 0;
+      const auto scanned = end;
+      end += static_cast<std::size_t>(n);
+      for (auto from = scanned; ; ) {
+        const auto found = static_cast<const char*>(std::memchr(buf.data() + from, delim, end - from));
+        if (found == nullptr) break;
+        const auto record_end = static_cast<std::size_t>(found - buf.data());
+        std::string_view record{buf.data() + begin, record_end - begin};
+        begin = from = record_end + 1;
+        co_yield record;
+      }
+    }
+    if (begin < end) {
+      std::string_view record{buf.data() + begin, end - begin};
+      co_yield record;
+    }
+  }
+
+  inline generator<std::string_view> read_records(std::filesystem::path path, char delim = '\n') {
+    return read_records(std::allocator_arg, pmem_pool, std::move(path), delim);
+  }
+
+  // yields each line of the (text) file, without the terminating newline
+  inline generator<std::string_view> read_lines(std::filesystem::path path) {
+    return read_records(std::allocator_arg, pmem_pool, std::move(path), '\n');
+  }
+
+} // namespace coro
+
+#endif //FILE_RECORDS_H
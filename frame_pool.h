@@ -0,0 +1,431 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Lock-free, per-thread coroutine frame cache exposed as a pmr memory_resource.
+ *
+ * Each thread owns a frame_cache that carves the blocks of each frame size class
+ * from slabs of its own, mapped from the OS, and that keeps a freed block on the
+ * free list of its slab. Only the owning thread ever touches a slab's free list,
+ * so allocating and deallocating a frame on the thread that created it involves no
+ * locking and no atomic read-modify-write. A slab is unmapped once all its blocks
+ * are free (bar the slab that the class currently allocates from).
+ *
+ * A frame deallocated on a foreign thread is collected into a batch for its owner
+ * and each batch is handed back to the owning thread with a single CAS push onto
+ * the owner's remote free list, which the owner drains (all at once) whenever the
+ * slab of a size class runs out of blocks, or once the list has grown to
+ * max_remote_blocks. A thread flushes its partial batch whenever it drains its own
+ * remote list, and when it exits. The remote list of the cache of an exited thread
+ * is drained by the thread that hands blocks back to it.
+ */
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <assert.h>
+#include <sys/mman.h>
+
+namespace coro {
+
+  namespace detail {
+
+    class frame_cache;
+
+    inline constexpr std::size_t frame_slab_size = std::size_t{64} << 10;
+
+    /**
+     * Maps a slab aligned to its size. The kernel tends to place each mapping right
+     * below the previous one, so a slab is over-mapped (to trim to a slab boundary)
+     * only should its mapping not be aligned already. Returns nullptr should the
+     * address space be exhausted.
+     */
+    inline void* map_frame_slab() noexcept {
+      void* slab = ::mmap(nullptr, frame_slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (slab == MAP_FAILED) return nullptr;
+      if ((reinterpret_cast<std::uintptr_t>(slab) & (frame_slab_size - 1)) == 0) return slab;
+      ::munmap(slab, frame_slab_size);
+      void* raw = ::mmap(nullptr, 2 * frame_slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED) return nullptr;
+      const auto begin = reinterpret_cast<std::uintptr_t>(raw);
+      const auto aligned = (begin + frame_slab_size - 1) & ~(frame_slab_size - 1);
+      if (aligned > begin) {
+        ::munmap(raw, aligned - begin);
+      }
+      if (const auto excess = begin + frame_slab_size - aligned; excess > 0) {
+        ::munmap(reinterpret_cast<void*>(aligned + frame_slab_size), excess);
+      }
+      return reinterpret_cast<void*>(aligned);
+    }
+
+    struct frame_free_node {
+      frame_free_node* next;
+    };
+
+    /**
+     * The header of a slab of the blocks of one size class, at the start of the slab.
+     * A foreign thread only reads the owner of a block's slab, so the fields that the
+     * owning thread updates are on a cache line of their own.
+     */
+    struct frame_slab {
+      static constexpr std::size_t cache_line_size = 64;
+
+      frame_cache* const owner;
+      const std::uint32_t size_class;
+      alignas(cache_line_size) frame_free_node* free = nullptr; // blocks freed back to the slab
+      std::byte* carve;            // the blocks that were never yet allocated
+      frame_slab* prev = nullptr;  // in the owner's list of the slabs of the size class with free blocks
+      frame_slab* next = nullptr;
+      std::uint32_t used = 0;      // blocks allocated, and not yet freed back to the slab
+      bool listed = false;
+
+      frame_slab(frame_cache* cache, std::uint32_t cls) noexcept
+        : owner{cache}, size_class{cls}, carve{reinterpret_cast<std::byte*>(this) + sizeof(frame_slab)} {}
+
+      static frame_slab* of(void* block) noexcept {
+        return reinterpret_cast<frame_slab*>(reinterpret_cast<std::uintptr_t>(block) & ~(frame_slab_size - 1));
+      }
+      std::byte* end() noexcept {
+        return reinterpret_cast<std::byte*>(this) + frame_slab_size;
+      }
+    };
+
+    static_assert(sizeof(frame_slab) % alignof(std::max_align_t) == 0); // so that the blocks are max aligned
+
+    class frame_cache {
+    public:
+      static constexpr size_t size_class_granularity = alignof(std::max_align_t);
+      static constexpr size_t num_size_classes = 64; // pooled blocks of up to 1 KiB (on x86-64)
+      static constexpr size_t foreign_batch_size = 32;
+      static constexpr size_t max_remote_blocks = 1024;
+
+      static constexpr size_t no_size_class = num_size_classes;
+
+      static constexpr size_t size_class_of(size_t bytes, size_t alignment) noexcept {
+        if (alignment > alignof(std::max_align_t) || bytes == 0) return no_size_class;
+        const size_t idx = (bytes - 1) / size_class_granularity;
+        return idx < num_size_classes ? idx : no_size_class;
+      }
+      static constexpr size_t block_size_of(size_t size_class) noexcept {
+        return (size_class + 1) * size_class_granularity;
+      }
+
+    private:
+      frame_slab* current[num_size_classes]{}; // the slab of each class that blocks are allocated from
+      frame_slab* partial[num_size_classes]{}; // the other slabs of each class that have free blocks
+
+      // batch of blocks deallocated on this thread but owned by another thread's cache
+      frame_cache* batch_owner = nullptr;
+      frame_free_node* batch_head = nullptr;
+      frame_free_node* batch_tail = nullptr;
+      size_t batch_count = 0;
+
+      // pushed to by foreign threads, drained by owner (on a cache line of its own)
+      alignas(frame_slab::cache_line_size) std::atomic<frame_free_node*> remote{nullptr};
+      std::atomic<size_t> remote_count{0}; // counted before each push, so may be ahead of the list
+      std::atomic<bool> abandoned{false};  // set and cleared under the mutex of the registry
+
+      frame_slab* map_slab(size_t size_class) {
+        void* slab = map_frame_slab();
+        if (slab == nullptr) throw std::bad_alloc{};
+        return ::new (slab) frame_slab{this, static_cast<std::uint32_t>(size_class)};
+      }
+
+      static void unmap_slab(frame_slab* slab) noexcept {
+        ::munmap(slab, frame_slab_size);
+      }
+
+      void list(frame_slab* slab) noexcept {
+        auto& head = partial[slab->size_class];
+        slab->prev = nullptr;
+        slab->next = head;
+        if (head != nullptr) head->prev = slab;
+        head = slab;
+        slab->listed = true;
+      }
+
+      void unlist(frame_slab* slab) noexcept {
+        if (slab->prev != nullptr) {
+          slab->prev->next = slab->next;
+        } else {
+          partial[slab->size_class] = slab->next;
+        }
+        if (slab->next != nullptr) slab->next->prev = slab->prev;
+        slab->prev = slab->next = nullptr;
+        slab->listed = false;
+      }
+
+      static void* take_block(frame_slab* slab, size_t size_class) noexcept {
+        if (auto node = slab->free; node != nullptr) {
+          slab->free = node->next;
+          ++slab->used;
+          return node;
+        }
+        const auto block_size = block_size_of(size_class);
+        if (static_cast<size_t>(slab->end() - slab->carve) >= block_size) {
+          void* block = slab->carve;
+          slab->carve += block_size;
+          ++slab->used;
+          return block;
+        }
+        return nullptr;
+      }
+
+      // the slab of a block freed whilst full is listed again, and unmapped once empty (unless it is current)
+      void free_block(frame_slab* slab, frame_free_node* node) noexcept {
+        const bool is_current = slab == current[slab->size_class];
+        if (--slab->used == 0 && !is_current) {
+          if (slab->listed) unlist(slab);
+          unmap_slab(slab);
+          return;
+        }
+        node->next = slab->free;
+        slab->free = node;
+        if (!slab->listed && !is_current) list(slab);
+      }
+
+      // (releases, so that a thread that pushes afterwards observes abandoned as set before the drain)
+      void drain_remote() noexcept {
+        auto node = remote.exchange(nullptr, std::memory_order_acq_rel);
+        size_t count = 0;
+        while (node != nullptr) {
+          auto next = node->next;
+          free_block(frame_slab::of(node), node);
+          node = next;
+          count++;
+        }
+        remote_count.fetch_sub(count, std::memory_order_relaxed);
+      }
+
+      void push_remote(frame_free_node* head, frame_free_node* tail, size_t count) noexcept {
+        remote_count.fetch_add(count, std::memory_order_relaxed);
+        auto top = remote.load(std::memory_order_relaxed);
+        do {
+          tail->next = top;
+        } while (!remote.compare_exchange_weak(top, head, std::memory_order_acq_rel, std::memory_order_relaxed));
+      }
+
+      // hands the blocks back to their owner, and drains its remote list should the owner have been abandoned
+      static void hand_back(frame_cache* owner, frame_free_node* head, frame_free_node* tail, size_t count) noexcept;
+
+      // the current slab of the class is full (or there is none yet)
+      void* allocate_slow(size_t size_class) {
+        flush_foreign_batch();
+        if (remote.load(std::memory_order_relaxed) != nullptr) { // only exchanged when there is something to drain
+          drain_remote();
+          if (auto slab = current[size_class]; slab != nullptr) {
+            if (auto block = take_block(slab, size_class)) return block;
+          }
+        }
+        // a full slab that is replaced is listed again once one of its blocks is freed
+        auto slab = partial[size_class];
+        if (slab != nullptr) {
+          unlist(slab);
+        } else {
+          slab = map_slab(size_class);
+        }
+        current[size_class] = slab;
+        return take_block(slab, size_class);
+      }
+
+    public:
+      void* allocate(size_t size_class) {
+        if (auto slab = current[size_class]; slab != nullptr) [[likely]] {
+          if (auto block = take_block(slab, size_class)) return block;
+        }
+        return allocate_slow(size_class);
+      }
+
+      void deallocate(void* p) noexcept {
+        auto slab = frame_slab::of(p);
+        auto node = static_cast<frame_free_node*>(p);
+        if (slab->owner == this) {
+          free_block(slab, node);
+        } else {
+          if (slab->owner != batch_owner) {
+            flush_foreign_batch();
+            batch_owner = slab->owner;
+            batch_tail = node;
+          }
+          node->next = batch_head;
+          batch_head = node;
+          if (++batch_count >= foreign_batch_size) {
+            flush_foreign_batch();
+          }
+        }
+        if (remote_count.load(std::memory_order_relaxed) >= max_remote_blocks) [[unlikely]] {
+          flush_foreign_batch();
+          drain_remote();
+        }
+      }
+
+      void flush_foreign_batch() noexcept {
+        if (batch_head != nullptr) {
+          hand_back(batch_owner, batch_head, batch_tail, batch_count);
+        }
+        batch_owner = nullptr;
+        batch_head = batch_tail = nullptr;
+        batch_count = 0;
+      }
+
+      // used once the deallocating thread no longer has a cache (i.e., during thread exit)
+      static void deallocate_orphaned(void* p) noexcept {
+        auto node = static_cast<frame_free_node*>(p);
+        hand_back(frame_slab::of(p)->owner, node, node, 1);
+      }
+
+      /**
+       * The remaining operations are only called under the mutex of the registry. Once
+       * abandoned, the remote list is drained by whichever thread hands blocks back (via
+       * collect()), and the slabs that are left empty are unmapped.
+       */
+      void abandon() noexcept {
+        abandoned.store(true, std::memory_order_relaxed);
+        collect();
+      }
+
+      void adopt() noexcept {
+        abandoned.store(false, std::memory_order_relaxed);
+      }
+
+      void collect() noexcept {
+        if (!abandoned.load(std::memory_order_relaxed)) return; // adopted in the meantime
+        drain_remote();
+        for (auto& slab : current) {
+          if (slab != nullptr && slab->used == 0) {
+            unmap_slab(slab);
+            slab = nullptr;
+          }
+        }
+      }
+
+      bool is_abandoned() const noexcept {
+        return abandoned.load(std::memory_order_relaxed);
+      }
+    };
+
+    /**
+     * Caches are never freed - when a thread exits its cache is abandoned (its slabs
+     * remain intact and foreign threads may still hand blocks back to it) and it is
+     * then adopted by the next thread that needs a cache. Hence the number of caches
+     * is bounded by the peak number of concurrent threads using the pool. The mutex
+     * is only taken when a thread first uses the pool and when it exits, to collect
+     * the blocks handed back to an abandoned cache, and by the allocations of threads
+     * whose cache is gone (i.e., during thread exit), which are served by a cache of
+     * the registry's own that is never adopted.
+     */
+    class frame_cache_registry {
+    private:
+      std::mutex mtx;
+      std::vector<frame_cache*> abandoned;
+      frame_cache orphaned;
+    public:
+      frame_cache_registry() {
+        orphaned.abandon();
+      }
+      frame_cache* adopt() {
+        std::lock_guard<std::mutex> lk{mtx};
+        if (abandoned.empty()) {
+          return new frame_cache{};
+        }
+        auto cache = abandoned.back();
+        abandoned.pop_back();
+        cache->adopt();
+        return cache;
+      }
+      void abandon(frame_cache* cache) {
+        cache->flush_foreign_batch();
+        std::lock_guard<std::mutex> lk{mtx};
+        cache->abandon();
+        abandoned.push_back(cache);
+      }
+      void collect(frame_cache* cache) {
+        std::lock_guard<std::mutex> lk{mtx};
+        cache->collect();
+      }
+      void* allocate_orphaned(size_t size_class) {
+        std::lock_guard<std::mutex> lk{mtx};
+        return orphaned.allocate(size_class);
+      }
+      static frame_cache_registry& instance() {
+        static auto registry = new frame_cache_registry{}; // intentionally leaked, see above
+        return *registry;
+      }
+    };
+
+    inline void frame_cache::hand_back(frame_cache* owner, frame_free_node* head, frame_free_node* tail,
+                                       size_t count) noexcept {
+      owner->push_remote(head, tail, count);
+      if (owner->is_abandoned()) [[unlikely]] { // observed by a push that follows the drain of abandon()
+        frame_cache_registry::instance().collect(owner);
+      }
+    }
+
+    inline thread_local frame_cache* tls_frame_cache = nullptr;
+    inline thread_local bool tls_frame_cache_exited = false;
+
+    struct frame_cache_lease {
+      frame_cache_lease() {
+        tls_frame_cache = frame_cache_registry::instance().adopt();
+      }
+      ~frame_cache_lease() {
+        auto cache = tls_frame_cache;
+        tls_frame_cache = nullptr;
+        tls_frame_cache_exited = true;
+        frame_cache_registry::instance().abandon(cache);
+      }
+    };
+
+    inline frame_cache* this_thread_frame_cache() {
+      if (tls_frame_cache == nullptr && !tls_frame_cache_exited) [[unlikely]] {
+        thread_local frame_cache_lease lease;
+      }
+      return tls_frame_cache;
+    }
+
+  } // namespace detail
+
+  /**
+   * pmr memory_resource that serves coroutine frames (and any other small
+   * allocations) from the calling thread's frame cache, see above. Allocations
+   * that are larger than the biggest size class, or that are over-aligned, are
+   * forwarded to std::pmr::new_delete_resource(). The resource is stateless, so
+   * all instances are interchangeable.
+   */
+  class frame_pool_resource : public std::pmr::memory_resource {
+    using cache = detail::frame_cache;
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+      const auto size_class = cache::size_class_of(bytes, alignment);
+      if (size_class == cache::no_size_class) {
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+      }
+      auto tc = detail::this_thread_frame_cache();
+      return tc != nullptr ? tc->allocate(size_class)
+                           : detail::frame_cache_registry::instance().allocate_orphaned(size_class);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+      if (cache::size_class_of(bytes, alignment) == cache::no_size_class) {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        return;
+      }
+      auto tc = detail::this_thread_frame_cache();
+      if (tc != nullptr) {
+        tc->deallocate(p);
+      } else {
+        cache::deallocate_orphaned(p);
+      }
+    }
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+      return dynamic_cast<const frame_pool_resource*>(&other) != nullptr;
+    }
+  };
+
+} // namespace coro
+
+#endif //FRAME_POOL_H
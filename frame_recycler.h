@@ -0,0 +1,97 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Per-thread LRU cache of destroyed coroutine frames, for generators that are
+ * created and destroyed over and over (e.g., once per request) - refer to the
+ * recycling_allocation policy of generator.h. A frame is cached by its exact
+ * size only - the frames of different generator functions that happen to be of
+ * the same size are interchangeable, so share the cache - and is handed to the
+ * next generator of that size created on the same thread, so the
+ * recreated frame lands in cache lines that are still warm, without any call of
+ * the allocator. Only the least recently destroyed frames are evicted, back to the
+ * global operator delete, once more than max_recycled_frames are cached.
+ */
+#ifndef FRAME_RECYCLER_H
+#define FRAME_RECYCLER_H
+
+#include <cstddef>
+#include <new>
+
+namespace coro {
+
+  namespace detail {
+
+    class frame_recycler {
+    public:
+      static constexpr std::size_t max_recycled_frames = 8;
+    private:
+      struct cached_frame {
+        std::size_t size;
+        void* frame;
+      };
+      cached_frame frames[max_recycled_frames]{}; // least recently destroyed first
+      std::size_t count = 0;
+    public:
+      frame_recycler() = default;
+      frame_recycler(const frame_recycler&) = delete;
+      frame_recycler& operator=(const frame_recycler&) = delete;
+      ~frame_recycler(); // (see below)
+      void release() noexcept {
+        for (std::size_t i = 0; i < count; i++) {
+          ::operator delete(frames[i].frame, frames[i].size);
+        }
+        count = 0;
+      }
+
+      void* allocate(std::size_t size) {
+        for (std::size_t i = count; i-- > 0; ) { // most recently destroyed first
+          if (frames[i].size == size) {
+            void* frame = frames[i].frame;
+            for (; i + 1 < count; i++) {
+              frames[i] = frames[i + 1];
+            }
+            --count;
+            return frame;
+          }
+        }
+        return ::operator new(size);
+      }
+
+      void deallocate(void* frame, std::size_t size) noexcept {
+        if (count == max_recycled_frames) { // evict the least recently destroyed frame
+          ::operator delete(frames[0].frame, frames[0].size);
+          for (std::size_t i = 1; i < count; i++) {
+            frames[i - 1] = frames[i];
+          }
+          --count;
+        }
+        frames[count++] = cached_frame{size, frame};
+      }
+    };
+
+    inline thread_local frame_recycler tls_frame_recycler{};
+    inline thread_local bool tls_frame_recycler_exited = false;
+
+    // frames may still be destroyed during thread exit, after the recycler of the thread
+    inline frame_recycler::~frame_recycler() {
+      release();
+      tls_frame_recycler_exited = true;
+    }
+
+    inline void* recycled_frame_allocate(std::size_t size) {
+      return tls_frame_recycler_exited ? ::operator new(size) : tls_frame_recycler.allocate(size);
+    }
+
+    inline void recycled_frame_deallocate(void* frame, std::size_t size) noexcept {
+      if (tls_frame_recycler_exited) {
+        ::operator delete(frame, size);
+      } else {
+        tls_frame_recycler.deallocate(frame, size);
+      }
+    }
+
+  } // namespace detail
+
+} // namespace coro
+
+#endif //FRAME_RECYCLER_H
@@ -0,0 +1,150 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Opt-in instrumentation recording the actual size of the coroutine frame of
+ * each generator function (keyed by call site, i.e., by the source location of
+ * the coroutine function), as requested of promise_type::operator new. Enable by
+ * defining CORO_FRAME_SIZE_STATS prior to including generator.h - otherwise the
+ * recording compiles away entirely.
+ *
+ * This allows fixed size (e.g., stack-based) pmr buffers to be sized from
+ * measured data instead of guessing, as neither g++ nor clang++ expose the size
+ * of a coroutine frame at compile time.
+ */
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <mutex>
+#include <source_location>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace coro {
+
+  struct frame_size_record {
+    const char* function_name;
+    const char* file_name;
+    std::uint_least32_t line;
+    std::size_t frame_size;      // as requested of promise_type::operator new
+    std::size_t allocation_size; // as allocated from the pmr memory_resource (includes the frame trailer)
+    std::size_t count;           // number of frames allocated
+  };
+
+  /**
+   * Registry of the frame sizes of generator functions, keyed by the source
+   * location of the coroutine function. Each thread caches the record of a call
+   * site, so the mutex is only taken by the first frame of the site on the thread,
+   * and the count of the frames is then bumped without locking.
+   */
+  class frame_size_registry {
+  private:
+    struct entry {
+      frame_size_record record; // (but for its count)
+      std::atomic<std::size_t> count{0};
+    };
+
+    mutable std::mutex mtx;
+    std::deque<entry> entries; // a deque, so the entries that the threads cache stay put
+
+    frame_size_registry() = default;
+
+    entry& entry_of(const std::source_location& loc, std::size_t frame_size, std::size_t allocation_size) {
+      std::lock_guard<std::mutex> lk{mtx};
+      auto it = std::find_if(entries.begin(), entries.end(), [&loc](const entry& e) {
+        return e.record.line == loc.line() && std::string_view{e.record.function_name} == loc.function_name()
+            && std::string_view{e.record.file_name} == loc.file_name();
+      });
+      if (it != entries.end()) return *it;
+      return entries.emplace_back(frame_size_record{loc.function_name(), loc.file_name(), loc.line(),
+                                                    frame_size, allocation_size, 0});
+    }
+  public:
+    frame_size_registry(const frame_size_registry&) = delete;
+    frame_size_registry& operator=(const frame_size_registry&) = delete;
+
+    void record(const std::source_location& loc, std::size_t frame_size, std::size_t allocation_size) {
+      // cached per thread, keyed by the (static) function name, as instrumentation.h caches its call sites
+      static thread_local std::unordered_map<const char*, entry*> cached;
+      auto [it, inserted] = cached.try_emplace(loc.function_name(), nullptr);
+      if (inserted) {
+        it->second = &entry_of(loc, frame_size, allocation_size);
+      }
+      it->second->count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<frame_size_record> snapshot() const {
+      std::lock_guard<std::mutex> lk{mtx};
+      std::vector<frame_size_record> records;
+      records.reserve(entries.size());
+      for (const auto& e : entries) {
+        records.push_back(e.record);
+        records.back().count = e.count.load(std::memory_order_relaxed);
+      }
+      return records;
+    }
+
+    /**
+     * Largest allocation size (frame plus trailer) recorded for generator functions
+     * whose (compiler generated, pretty) function name contains all of the specified
+     * sub-strings, e.g., max_allocation_size({"fibonacci", "long double"}), or zero
+     * if no such function has been recorded.
+     */
+    std::size_t max_allocation_size(std::initializer_list<std::string_view> name_contains) const {
+      std::lock_guard<std::mutex> lk{mtx};
+      std::size_t max_size = 0;
+      for (const auto& e : entries) {
+        const auto& r = e.record;
+        const std::string_view name{r.function_name};
+        if (std::all_of(name_contains.begin(), name_contains.end(),
+                        [name](std::string_view s) { return name.find(s) != std::string_view::npos; })) {
+          max_size = std::max(max_size, r.allocation_size);
+        }
+      }
+      return max_size;
+    }
+
+    static frame_size_registry& instance() {
+      static frame_size_registry registry;
+      return registry;
+    }
+  };
+
+  /**
+   * Compile-time helper for sizing a bump arena (or fixed buffer) that is to hold
+   * the specified number of frames of a measured allocation size (refer to
+   * frame_size_record::allocation_size), allowing for alignment padding.
+   */
+  constexpr std::size_t frame_buffer_size(std::size_t allocation_size, std::size_t num_frames = 1) noexcept {
+    constexpr auto align = alignof(std::max_align_t);
+    return num_frames * ((allocation_size + align - 1) & ~(align - 1)) + align - 1;
+  }
+
+  namespace detail {
+#ifdef CORO_FRAME_SIZE_STATS
+    // handed from operator new to the promise constructor, which knows the call site
+    inline thread_local std::size_t last_frame_size = 0;
+    inline thread_local std::size_t last_allocation_size = 0;
+
+    inline void note_frame_allocation(std::size_t frame_size, std::size_t allocation_size) noexcept {
+      last_frame_size = frame_size;
+      last_allocation_size = allocation_size;
+    }
+    inline void record_frame_size(const std::source_location& loc) {
+      frame_size_registry::instance().record(loc, last_frame_size, last_allocation_size);
+    }
+#else
+    constexpr void note_frame_allocation(std::size_t, std::size_t) noexcept {}
+    constexpr void record_frame_size(const std::source_location&) noexcept {}
+#endif
+  } // namespace detail
+
+} // namespace coro
+
+#endif //FRAME_STATS_H
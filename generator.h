@@ -13,43 +13,406 @@
 #ifndef GENERATOR_H
 #define GENERATOR_H
 
+#include <concepts>
 #include <coroutine>
+#include <exception>
+#include <iterator>
 #include <memory>
 #include <optional>
-#include <iostream>
+#include <source_location>
+#include <ranges>
+#include <span>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
 #include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
 #include <assert.h>
+#include "frame_pool.h"
+#include "frame_recycler.h"
+#include "frame_stats.h"
+#include "instrumentation.h"
 
 namespace coro {
 
-  // the default pmr memory resource is a thread-safe allocator that uses the global new and delete
-  inline static std::pmr::synchronized_pool_resource mem_pool{std::pmr::new_delete_resource()}; // default allocator
+  // a thread-safe (internally locking) pool allocator that uses the global new and delete
+  inline std::pmr::synchronized_pool_resource mem_pool{std::pmr::new_delete_resource()};
 
-  inline static thread_local std::pmr::memory_resource* pmem_pool = &mem_pool; // never owns any supplied mem resource
-  inline static void set_pmr_mem_pool(std::pmr::memory_resource* mem_pool_cust) {
+  // the default pmr memory resource is a lock-free, per-thread coroutine frame cache (refer to frame_pool.h)
+  inline frame_pool_resource frame_pool{}; // default allocator
+
+  inline thread_local std::pmr::memory_resource* pmem_pool = &frame_pool; // never owns any supplied mem resource
+  inline void set_pmr_mem_pool(std::pmr::memory_resource* mem_pool_cust) {
     pmem_pool = mem_pool_cust; // set a custom pmr allocator (but does not take ownership)
   }
-  inline static void reset_default_pmr_mem_pool() {
-    pmem_pool = &mem_pool; // reset using the default allocator (does not take ownership)
+  inline void reset_default_pmr_mem_pool() {
+    pmem_pool = &frame_pool; // reset using the default allocator (does not take ownership)
+  }
+
+#ifdef CORO_INSTRUMENTATION
+  // labels the frame allocations from the default memory resources in the instrumentation dumps
+  inline const bool default_frame_resources_named = (name_frame_resource(&frame_pool, "frame_pool"),
+                                                     name_frame_resource(&mem_pool, "mem_pool"), true);
+#endif
+
+  // any of these can be passed as the coroutine argument following std::allocator_arg
+  inline std::pmr::memory_resource* frame_resource_of(std::pmr::memory_resource* mr) noexcept { return mr; }
+  inline std::pmr::memory_resource* frame_resource_of(std::pmr::memory_resource& mr) noexcept { return &mr; }
+  template<typename U>
+  std::pmr::memory_resource* frame_resource_of(const std::pmr::polymorphic_allocator<U>& alloc) noexcept {
+    return alloc.resource();
+  }
+
+  template<typename A>
+  concept frame_allocator = requires(A& a) {
+    { frame_resource_of(a) } -> std::same_as<std::pmr::memory_resource*>;
+  };
+
+  /**
+   * Base class for coroutine promise types that allocates the coroutine frame from
+   * a pmr memory_resource. By default the frame is allocated from pmem_pool, but the
+   * coroutine function may instead accept std::allocator_arg followed by a pmr
+   * memory_resource (pointer or reference) or a std::pmr::polymorphic_allocator as
+   * its leading parameters (after the implicit object parameter of a member
+   * function), the way std::generator does, in which case the frame is allocated
+   * from that memory_resource.
+   *
+   * The memory_resource is recorded in a trailer at the end of the frame, so the
+   * frame is always freed back to where it was allocated from, even if pmem_pool
+   * has been changed in the meantime.
+   */
+  struct pmr_promise_allocation {
+  private:
+    using resource_ptr = std::pmr::memory_resource*;
+    static constexpr std::size_t trailer_offset(std::size_t sz) noexcept {
+      return (sz + alignof(resource_ptr) - 1) & ~(alignof(resource_ptr) - 1);
+    }
+    static void* allocate_frame(std::pmr::memory_resource* mr, std::size_t sz) {
+      assert(mr != nullptr);
+      auto frame = static_cast<std::byte*>(mr->allocate(trailer_offset(sz) + sizeof(resource_ptr)));
+      ::new (frame + trailer_offset(sz)) resource_ptr{mr};
+      detail::note_frame_allocation(sz, trailer_offset(sz) + sizeof(resource_ptr));
+      detail::note_frame_resource_allocate(mr, trailer_offset(sz) + sizeof(resource_ptr));
+      return frame;
+    }
+  public:
+    static void* operator new(std::size_t sz) {
+      return allocate_frame(pmem_pool, sz);
+    }
+    // (always inlined, as otherwise g++ at -O0 warns that the sized operator delete below, which the coroutine
+    // frees the frame with, does not match these - it never pairs a template operator new with a deallocation function)
+    template<frame_allocator Alloc, typename... Args>
+    [[gnu::always_inline]] static void* operator new(std::size_t sz, std::allocator_arg_t, Alloc& alloc, Args&...) {
+      return allocate_frame(frame_resource_of(alloc), sz);
+    }
+    template<typename This, frame_allocator Alloc, typename... Args>
+    [[gnu::always_inline]] static void* operator new(std::size_t sz, This&, std::allocator_arg_t, Alloc& alloc, Args&...) {
+      return allocate_frame(frame_resource_of(alloc), sz);
+    }
+    static void operator delete(void* ptr, std::size_t sz) noexcept {
+      auto frame = static_cast<std::byte*>(ptr);
+      auto mr = *std::launder(reinterpret_cast<resource_ptr*>(frame + trailer_offset(sz)));
+      detail::note_frame_resource_deallocate(mr, trailer_offset(sz) + sizeof(resource_ptr));
+      mr->deallocate(frame, trailer_offset(sz) + sizeof(resource_ptr));
+    }
+  };
+
+  /**
+   * Allocation policies of the generator template classes, which determine how the
+   * coroutine frame is allocated:
+   *
+   * pmr_allocation       - from a pmr memory_resource (refer to pmr_promise_allocation)
+   * elidable_allocation  - via the global operator new, without any pmr indirection, so
+   *                        that the compiler may elide the heap allocation altogether
+   *                        (HALO) when the generator does not escape the scope of its caller
+   *                        (clang++ does so at -O2 and above; g++ does not elide coroutine
+   *                        frame allocations)
+   * recycling_allocation - via the global operator new, but a destroyed frame is cached
+   *                        by the thread (refer to frame_recycler.h) and reused by the
+   *                        next generator of the same frame size that the thread creates,
+   *                        for generators that are created and destroyed over and over
+   */
+  struct pmr_allocation {};
+  struct elidable_allocation {};
+  struct recycling_allocation {};
+
+  template<typename Policy>
+  struct promise_allocation;
+
+  template<>
+  struct promise_allocation<pmr_allocation> : pmr_promise_allocation {
+    static void record_frame_size(const std::source_location& loc) {
+      detail::record_frame_size(loc);
+    }
+  };
+
+  template<>
+  struct promise_allocation<elidable_allocation> {
+    static constexpr void record_frame_size(const std::source_location&) noexcept {}
+  };
+
+  template<>
+  struct promise_allocation<recycling_allocation> {
+    static void* operator new(std::size_t sz) {
+      auto frame = detail::recycled_frame_allocate(sz);
+      detail::note_frame_allocation(sz, sz);
+      return frame;
+    }
+    static void operator delete(void* ptr, std::size_t sz) noexcept {
+      detail::recycled_frame_deallocate(ptr, sz);
+    }
+    static void record_frame_size(const std::source_location& loc) {
+      detail::record_frame_size(loc);
+    }
+  };
+
+  template<typename P>
+  concept allocation_policy = std::same_as<P, pmr_allocation> || std::same_as<P, elidable_allocation>
+                              || std::same_as<P, recycling_allocation>;
+
+  /**
+   * Exception policies of the generator template classes, which determine what becomes
+   * of an exception that escapes the body of the coroutine:
+   *
+   * propagate_exceptions   - the exception is captured and rethrown to the consumer from
+   *                          next() or from incrementing the iterator (the fast path, i.e.,
+   *                          resuming a coroutine that suspends on co_yield, is unaffected)
+   * terminate_on_exception - std::terminate() is called; the promise does not have to store
+   *                          a std::exception_ptr, e.g., for latency critical builds
+   */
+  struct propagate_exceptions {};
+  struct terminate_on_exception {};
+
+  template<typename Policy>
+  struct promise_exception;
+
+  template<>
+  struct promise_exception<propagate_exceptions> {
+  private:
+    std::exception_ptr exception{};
+  public:
+    void unhandled_exception() noexcept {
+      exception = std::current_exception();
+    }
+    void rethrow_if_exception() {
+      if (exception) [[unlikely]] {
+        std::rethrow_exception(std::exchange(exception, nullptr));
+      }
+    }
+  };
+
+  template<>
+  struct promise_exception<terminate_on_exception> {
+    [[noreturn]] void unhandled_exception() noexcept {
+      std::terminate();
+    }
+    constexpr void rethrow_if_exception() const noexcept {}
+  };
+
+  template<typename P>
+  concept exception_policy = std::same_as<P, propagate_exceptions> || std::same_as<P, terminate_on_exception>;
+
+  /**
+   * Wraps a range so that co_yield coro::elements_of(range) within a generator yields
+   * each of the range's elements in turn (as std::ranges::elements_of does for
+   * std::generator). A nested coro::generator<T> is resumed directly by the consumer
+   * (via symmetric transfer), so the cost per element does not depend on the depth
+   * of nesting.
+   */
+  template<typename R>
+  struct elements_of {
+    [[no_unique_address]] R range;
+  };
+  template<typename R>
+  elements_of(R&&) -> elements_of<R&&>;
+
+  /**
+   * co_await coro::this_stop_token() within a generator evaluates (without suspending)
+   * to the std::stop_token bound to the generator via set_stop_token() - a token that
+   * can never be stopped unless one was bound - so that a long running generator can
+   * stop early, once its consumer has gone:
+   *
+   *   const auto stop = co_await coro::this_stop_token();
+   *   while (!stop.stop_requested()) { co_yield expensive_next(); }
+   */
+  struct this_stop_token_t {};
+  constexpr this_stop_token_t this_stop_token() noexcept { return {}; }
+
+  namespace detail {
+    struct stop_token_awaiter {
+      std::stop_token token;
+      constexpr bool await_ready() const noexcept { return true; }
+      constexpr void await_suspend(std::coroutine_handle<>) const noexcept {}
+      std::stop_token await_resume() noexcept { return std::move(token); }
+    };
+  } // namespace detail
+
+  // the absence of a hook of sequence_hooks (see below)
+  struct no_hook {};
+
+  /**
+   * Hooks of a generator, which let the consumer bypass resuming its coroutine per
+   * value where the coroutine can compute a run of its values directly:
+   *
+   * fill - a callable of signature std::size_t(std::span<T>), which writes the values that
+   *        follow the one yielded most recently into a prefix of the span and returns how
+   *        many it wrote, for generator::generate_into()
+   * skip - a callable of signature std::size_t(std::size_t n), which discards up to n of
+   *        the values that follow the one yielded most recently and returns how many it
+   *        discarded (possibly fewer, e.g., none when it cannot jump that far), for
+   *        generator::skip()
+   *
+   * Either may be no_hook. Both must advance the loop state of the coroutine past the
+   * values they wrote or discarded, such that the coroutine continues after them. The
+   * coroutine registers its hooks via co_yield, which does not suspend it:
+   *
+   *   T i = start;
+   *   coro::sequence_hooks hooks{
+   *     [&i](std::span<T> out) { return coro::iota_fill(out, i); },
+   *     [&i](std::size_t n) { i += static_cast<T>(n); return n; }
+   *   };
+   *   co_yield hooks;
+   *   while (true) {
+   *     co_yield i++;
+   *   }
+   *
+   * The hooks are then called instead of resuming the coroutine whilst the coroutine is
+   * suspended at any of its subsequent co_yield expressions - so the sequence_hooks must
+   * remain in scope for as long as the coroutine yields.
+   */
+  template<typename Fill, typename Skip = no_hook>
+  struct sequence_hooks {
+    [[no_unique_address]] Fill fill;
+    [[no_unique_address]] Skip skip{};
+  };
+  template<typename Fill, typename Skip>
+  sequence_hooks(Fill, Skip) -> sequence_hooks<Fill, Skip>;
+  template<typename Fill>
+  sequence_hooks(Fill) -> sequence_hooks<Fill>;
+
+  namespace detail {
+    // the type-erased hooks of a sequence_hooks, of which null ones are absent
+    template<typename T>
+    struct sequence_hook_table {
+      std::size_t (*fill)(void*, std::span<T>);
+      std::size_t (*skip)(void*, std::size_t);
+    };
+
+    template<typename T, typename H>
+    inline constexpr sequence_hook_table<T> sequence_hook_table_of{
+      [] {
+        if constexpr (std::same_as<decltype(H::fill), no_hook>) {
+          return static_cast<std::size_t (*)(void*, std::span<T>)>(nullptr);
+        } else {
+          static_assert(std::is_invocable_r_v<std::size_t, decltype(H::fill)&, std::span<T>>,
+                        "the fill hook of sequence_hooks must be invocable as std::size_t(std::span<T>)");
+          return +[](void* hooks, std::span<T> out) -> std::size_t { return static_cast<H*>(hooks)->fill(out); };
+        }
+      }(),
+      [] {
+        if constexpr (std::same_as<decltype(H::skip), no_hook>) {
+          return static_cast<std::size_t (*)(void*, std::size_t)>(nullptr);
+        } else {
+          static_assert(std::is_invocable_r_v<std::size_t, decltype(H::skip)&, std::size_t>,
+                        "the skip hook of sequence_hooks must be invocable as std::size_t(std::size_t)");
+          return +[](void* hooks, std::size_t n) -> std::size_t { return static_cast<H*>(hooks)->skip(n); };
+        }
+      }()
+    };
+  } // namespace detail
+
+  /**
+   * Fills out with the ascending sequence that starts at next, and advances next past
+   * it, e.g., as the fill hook of sequence_hooks. Integral values are computed a SIMD
+   * register (32 bytes, e.g., 8 ints per AVX2 store) at a time, which the compiler
+   * vectorizes; floating point values are accumulated one after another, so they are
+   * the same as those of a coroutine that increments its loop variable.
+   */
+  template<typename T> requires std::integral<T> || std::floating_point<T>
+  std::size_t iota_fill(std::span<T> out, T& next) noexcept {
+    T value = next; // a local copy, as next might otherwise alias the elements of out
+    std::size_t k = 0;
+    if constexpr (std::integral<T>) {
+      constexpr std::size_t lanes = 32 / sizeof(T);
+      for (; k + lanes <= out.size(); k += lanes) {
+        for (std::size_t l = 0; l < lanes; l++) {
+          out[k + l] = static_cast<T>(value + static_cast<T>(l));
+        }
+        value = static_cast<T>(value + static_cast<T>(lanes));
+      }
+    }
+    for (; k < out.size(); k++) {
+      out[k] = value++;
+    }
+    next = value;
+    return out.size();
   }
 
+  namespace detail {
+    /**
+     * How the promise of a generator holds the value most recently yielded: a small
+     * trivially copyable value (no larger than a pointer, e.g., a scalar) is copied into
+     * uninitialized aligned storage within the promise, which costs no more than storing
+     * its address and spares the consumer a dependent load from elsewhere in the frame;
+     * any other value is referred to where it lives in the coroutine frame (zero-copy).
+     * Neither requires T to be default-constructible.
+     */
+    template<typename T, bool Inline = std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void*)>
+    struct yielded_value {
+      static constexpr bool copies = false;
+      T* ptr = nullptr;
+      void set(T& value) noexcept { ptr = std::addressof(value); }
+      T& get() const noexcept { return *ptr; }
+      bool has_value() const noexcept { return ptr != nullptr; }
+    };
+
+    template<typename T>
+    struct yielded_value<T, true> {
+      static constexpr bool copies = true;
+      alignas(T) mutable std::byte storage[sizeof(T)]; // uninitialized until the first co_yield
+      bool yielded = false;
+      void set(const T& value) noexcept {
+        std::memcpy(storage, std::addressof(value), sizeof(T)); // implicitly creates the T
+        yielded = true;
+      }
+      T& get() const noexcept { return *std::launder(reinterpret_cast<T*>(storage)); }
+      bool has_value() const noexcept { return yielded; }
+    };
+  } // namespace detail
+
   /**
    * General purpose C++20 coroutine generator template class.
    *
+   * A generator is a move-only std::ranges::input_range and std::ranges::view, so it
+   * composes with std::views (and with the fused adaptors of pipeline.h). It is not a
+   * borrowed range, as its iterators refer to the coroutine frame that the generator
+   * owns, i.e., they dangle once the generator is destroyed.
+   *
    * @tparam T the type of value that the generator returns to the caller
+   * @tparam ExceptionPolicy what becomes of an exception escaping the coroutine (see above)
+   * @tparam AllocationPolicy how the coroutine frame is allocated (see above)
    */
-  template<typename T>
-  class [[nodiscard]] generator {
+  template<typename T, exception_policy ExceptionPolicy = propagate_exceptions,
+           allocation_policy AllocationPolicy = pmr_allocation>
+  class [[nodiscard]] generator : public std::ranges::view_interface<generator<T, ExceptionPolicy, AllocationPolicy>> {
+    static_assert(std::is_object_v<T>, "generator<T> requires an object type");
   public:
+    using value_type = std::remove_cv_t<T>;
     struct promise_type;
     using coro_handle_type = std::coroutine_handle<promise_type>;
   private:
     coro_handle_type coro;
+    // whether the coroutine has been resumed by peek() - the coroutine remains suspended at
+    // the peeked value, which the next call to next() then merely consumes
+    mutable bool peeked = false;
   public:
     explicit generator(coro_handle_type h) : coro{h} {}
     generator(const generator &) = delete;            // do not allow copy construction
     generator &operator=(const generator &) = delete; // do not allow copy assignment
-    generator(generator &&oth) noexcept : coro{std::move(oth.coro)} {
+    generator(generator &&oth) noexcept : coro{std::move(oth.coro)}, peeked{std::exchange(oth.peeked, false)} {
       oth.coro = nullptr; // insure the other moved handle is null
     }
     generator &operator=(generator &&other) noexcept {
@@ -59,6 +422,7 @@ namespace coro {
         }
         coro = std::move(other.coro); // move other coro handle into self
         other.coro = nullptr;         // insure other moved handle is null
+        peeked = std::exchange(other.peeked, false);
       }
       return *this;
     }
@@ -71,32 +435,220 @@ namespace coro {
 
   public: // API
     bool next() const {
-      if (!coro || coro.done()) return false; // nothing more to process
-      coro.resume();
-      return !coro.done();
+      if (peeked) {
+        peeked = false;
+        return true;
+      }
+      return resume();
+    }
+
+    /**
+     * Looks ahead at the value that the next call to next() advances to, without consuming
+     * it, or returns nullptr if there is none. The lookahead does not copy the value - the
+     * coroutine is resumed, and remains suspended at the peeked value - so any reference
+     * obtained from getValueRef() before is invalidated, and getValueRef() refers to the
+     * peeked value thereafter.
+     */
+    T* peek() const {
+      if (!peeked) {
+        if (!resume()) return nullptr;
+        peeked = true;
+      }
+      return std::addressof(coro.promise().current_value.get());
+    }
+
+    /**
+     * Discards the next n values, and returns how many it discarded - fewer than n only if
+     * the sequence has completed. Uses the skip hook of the coroutine (refer to
+     * sequence_hooks) where it has registered one, e.g., to jump to the n-th value at a cost
+     * of O(1) or O(log n), otherwise resumes the coroutine n times. The value of
+     * getValueRef() is unspecified thereafter, until the next call to next().
+     */
+    std::size_t skip(std::size_t n) const {
+      std::size_t skipped = 0;
+      if (n > 0 && peeked) { // the peeked value is the first one to discard
+        peeked = false;
+        ++skipped;
+      }
+      bool hook_declined = false; // once the hook skips none, the values that remain are resumed for
+      while (skipped < n && coro && !coro.done()) {
+        auto& p = coro.promise().leaf.promise(); // the innermost active (nested) generator
+        if (!hook_declined && p.hooks != nullptr && p.hooks->skip != nullptr) {
+          const std::size_t jumped = p.hooks->skip(p.hooks_state, n - skipped);
+          hook_declined = jumped == 0;
+          skipped += jumped;
+          if (skipped == n) break;
+        }
+        if (!resume()) break;
+        ++skipped;
+      }
+      return skipped;
+    }
+
+    /**
+     * Binds the token that co_await this_stop_token() evaluates to within the coroutine
+     * (and within the generators it nests), e.g., one that is stopped once the client
+     * that consumes the generator disconnects. Adaptors that run the generator on other
+     * threads, e.g., prefetch(), bind a token of their own to it, which they stop when
+     * they are destroyed - or once the token bound to them is stopped. To be called
+     * before the first call to next(), as an adaptor obtains its token when it starts.
+     */
+    void set_stop_token(std::stop_token token) noexcept {
+      if (coro) coro.promise().stop_token = std::move(token);
     }
 
     std::optional<T> getValue() noexcept {
-      return coro ? std::make_optional(coro.promise().current_value) : std::nullopt;
+      return has_value() ? std::make_optional(coro.promise().current_value.get()) : std::nullopt;
     }
 
-  public:
-    // implementation of above opaque declaration promise_type
-    struct promise_type {
-    public:
-      void* operator new(std::size_t sz) {
-        assert(pmem_pool != nullptr);
-        return pmem_pool->allocate(sz);
+    /**
+     * Zero-copy access to the value most recently yielded by the coroutine (or, for a
+     * small trivially copyable T, to the promise's copy of it - refer to
+     * detail::yielded_value); the reference remains valid until the next call to
+     * next() (or until the generator is destroyed). The caller may move from it, e.g.,
+     * for move-only value types.
+     * Precondition: the preceding call to next() returned true.
+     */
+    T& getValueRef() const noexcept {
+      assert(has_value());
+      return coro.promise().current_value.get();
+    }
+
+    /**
+     * Writes the values that follow into out, as many as fit, and returns how many it
+     * wrote - fewer than the size of out only if the sequence has completed. Uses the
+     * fill hook of the coroutine (refer to sequence_hooks) where it has registered one,
+     * otherwise resumes the coroutine per value (and copies the value, or moves it if T
+     * is not copyable). The value of getValueRef() is unspecified thereafter, until the
+     * next call to next().
+     */
+    std::size_t generate_into(std::span<value_type> out) const {
+      std::size_t n = 0;
+      if (!out.empty() && peeked) { // the peeked value is the first one to write
+        peeked = false;
+        out[n++] = take_value();
       }
-      void operator delete(void* ptr, std::size_t sz) {
-        assert(pmem_pool != nullptr);
-        pmem_pool->deallocate(ptr, sz);
+      while (n < out.size() && coro && !coro.done()) {
+        auto& p = coro.promise().leaf.promise(); // the innermost active (nested) generator
+        if (p.hooks != nullptr && p.hooks->fill != nullptr) {
+          n += p.hooks->fill(p.hooks_state, out.subspan(n));
+          if (n == out.size()) break;
+        }
+        if (!resume()) break;
+        out[n++] = take_value();
+      }
+      return n;
+    }
+
+  private:
+    bool resume() const {
+      if (!coro || coro.done()) return false; // nothing more to process
+      auto& p = coro.promise();
+      const auto resumed_at = p.before_resume(); // (refer to instrumentation.h)
+      p.leaf.resume(); // the innermost active (nested) generator
+      p.after_resume(resumed_at);
+      if (coro.done()) {
+        coro.promise().rethrow_if_exception();
+        return false;
       }
+      return true;
+    }
+
+    decltype(auto) take_value() const noexcept {
+      if constexpr (std::is_copy_assignable_v<value_type>) {
+        return static_cast<const value_type&>(getValueRef());
+      } else {
+        return std::move(getValueRef());
+      }
+    }
+
+    bool has_value() const noexcept {
+      return coro && !coro.done() && coro.promise().current_value.has_value();
+    }
+
+  public:
+    // implementation of above opaque declaration promise_type
+    struct promise_type : promise_allocation<AllocationPolicy>, promise_exception<ExceptionPolicy>,
+                          detail::promise_instrumentation {
     private:
-      T current_value{};
+      // the value of the last co_yield expression (or where it lives in the coroutine
+      // frame, for as long as the coroutine remains suspended - see yielded_value)
+      // (only maintained in the root promise of nested generators)
+      detail::yielded_value<value_type> current_value;
+      coro_handle_type parent{}; // generator that yields the elements of this one, if any
+      union {
+        coro_handle_type leaf; // innermost active generator, of the root promise (whose parent is null)
+        promise_type* root;    // outermost generator, i.e., the one the consumer iterates, of any other
+      };
+      void* hooks_state = nullptr; // the registered sequence_hooks, if any
+      const detail::sequence_hook_table<value_type>* hooks = nullptr;
+      std::stop_token stop_token; // (only maintained in the root promise of nested generators)
       friend class generator;
+
+      promise_type& root_promise() noexcept {
+        return parent ? *root : *this;
+      }
+
+      struct final_awaiter {
+        constexpr bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(coro_handle_type h) noexcept {
+          auto& p = h.promise();
+          if (!p.parent) {
+            return std::noop_coroutine(); // return control to the consumer
+          }
+          p.root->leaf = p.parent; // the root promise of a nested generator is another promise
+          return p.parent; // resume the parent right after its co_yield elements_of(...)
+        }
+        constexpr void await_resume() const noexcept {}
+      };
+
+      template<typename G> // generator (takes ownership) or generator& (does not)
+      struct nested_awaiter {
+        G nested;
+        bool await_ready() const noexcept {
+          return !nested.coro || nested.coro.done();
+        }
+        std::coroutine_handle<> await_suspend(coro_handle_type h) noexcept {
+          auto& root = h.promise().root_promise();
+          auto& np = nested.coro.promise();
+          const auto nested_leaf = np.leaf; // np is the root promise of its own generator so far
+          // the nested generator may itself be suspended within nested generators
+          for (auto c = nested_leaf; c != nested.coro; c = c.promise().parent) {
+            c.promise().root = &root;
+          }
+          np.root = &root;
+          np.parent = h;
+          root.leaf = nested_leaf;
+          if (nested.peeked) { // suspended at its peeked value, so hand that to the consumer first
+            nested.peeked = false;
+            root.current_value.set(np.current_value.get());
+            return std::noop_coroutine();
+          }
+          return nested_leaf;
+        }
+        void await_resume() {
+          if (nested.coro) {
+            nested.coro.promise().rethrow_if_exception(); // propagate into the body of the parent
+          }
+        }
+      };
+
+      template<typename R>
+      using stored_range_t = std::conditional_t<std::is_lvalue_reference_v<R>, R, std::remove_cvref_t<R>>;
+
+      template<typename R>
+      static generator elements_of_range(R range) {
+        for (auto&& e : range) {
+          co_yield e;
+        }
+      }
     public:
-      promise_type() = default;
+      // the default argument is the source location of the coroutine (generator) function
+      promise_type(const std::source_location& loc = std::source_location::current())
+          : leaf{coro_handle_type::from_promise(*this)} {
+        this->record_frame_size(loc);
+        this->instrument_site(loc);
+      }
       ~promise_type() = default;
       promise_type(const promise_type&) = delete;
       promise_type(promise_type&&) = delete;
@@ -112,38 +664,103 @@ namespace coro {
       }
 
       auto final_suspend() noexcept {
-        return std::suspend_always{};
+        return final_awaiter{};
       }
 
       void return_void() {}
 
-      auto yield_value(T some_value) {
-        current_value = some_value;
+      detail::stop_token_awaiter await_transform(this_stop_token_t) noexcept {
+        return {root_promise().stop_token};
+      }
+
+      // yielding an lvalue does not copy - the consumer is handed a reference to it
+      // (other than for a small trivially copyable T - see yielded_value)
+      auto yield_value(value_type& some_value) noexcept {
+        root_promise().current_value.set(some_value);
+        this->on_yield();
+        return std::suspend_always{};
+      }
+
+      // a yielded rvalue (temporary) lives until the coroutine resumes, so the
+      // consumer may move from it
+      auto yield_value(value_type&& some_value) noexcept {
+        root_promise().current_value.set(some_value);
+        this->on_yield();
+        return std::suspend_always{};
+      }
+
+      // a small trivially copyable const lvalue is copied into the promise likewise
+      auto yield_value(const value_type& some_value) noexcept requires detail::yielded_value<value_type>::copies {
+        root_promise().current_value.set(some_value);
+        this->on_yield();
         return std::suspend_always{};
       }
 
-      void unhandled_exception() {
-        std::terminate();
+      // any other const lvalue is copied into the awaiter, which also lives in the frame
+      // for the duration of the suspension, so the consumer never mutates a const object
+      auto yield_value(const value_type& some_value)
+          requires (!detail::yielded_value<value_type>::copies && std::copy_constructible<value_type>) {
+        struct copy_awaiter {
+          value_type value_copy;
+          constexpr bool await_ready() const noexcept { return false; }
+          void await_suspend(coro_handle_type h) noexcept {
+            h.promise().root_promise().current_value.set(value_copy);
+          }
+          constexpr void await_resume() const noexcept {}
+        };
+        this->on_yield();
+        return copy_awaiter{some_value};
+      }
+
+      // registers the hooks of the coroutine (refer to sequence_hooks), without suspending
+      template<typename Fill, typename Skip>
+      std::suspend_never yield_value(sequence_hooks<Fill, Skip>& registered) noexcept {
+        hooks_state = std::addressof(registered);
+        hooks = &detail::sequence_hook_table_of<value_type, sequence_hooks<Fill, Skip>>;
+        return {};
+      }
+
+      // the consumer resumes the nested generator directly, until it completes
+      template<typename R> requires std::same_as<std::remove_cvref_t<R>, generator>
+      auto yield_value(elements_of<R> nested) noexcept {
+        using stored_type = std::conditional_t<std::is_lvalue_reference_v<R>, generator&, generator>;
+        return nested_awaiter<stored_type>{std::forward<R>(nested.range)};
+      }
+
+      // any other range is iterated by a nested generator on its behalf
+      template<std::ranges::input_range R> requires (!std::same_as<std::remove_cvref_t<R>, generator>)
+      auto yield_value(elements_of<R> nested) {
+        return yield_value(coro::elements_of{elements_of_range<stored_range_t<R>>(std::forward<R>(nested.range))});
       }
     };
 
+    // so that the promise, and with it the coroutine state the consumer touches per resume, stays within a
+    // cache line (64 bytes) and as many suspended generators as possible fit in the L1 cache of a core
+    // (unless enlarged by the instrumentation of instrumentation.h)
+    static_assert(!std::is_scalar_v<value_type> || sizeof(promise_type) <= 64 + detail::promise_instrumentation_size,
+                  "the promise of a generator of a scalar T should fit in a cache line");
+
     struct iterator {
       using difference_type [[maybe_unused]] = std::ptrdiff_t;
-      using value_type [[maybe_unused]] = T;
+      using value_type [[maybe_unused]] = generator::value_type;
       coro_handle_type hdl = nullptr;
       iterator() = default;
       iterator(coro_handle_type h) : hdl{h} {}
       void getNext() {
         if (hdl) {
-          hdl.resume();
+          auto& p = hdl.promise();
+          const auto resumed_at = p.before_resume();
+          p.leaf.resume();
+          p.after_resume(resumed_at);
           if (hdl.done()) {
-            hdl = nullptr;
+            auto done_hdl = std::exchange(hdl, nullptr);
+            done_hdl.promise().rethrow_if_exception();
           }
         }
       }
       T& operator*() const {
         assert(hdl);
-        return hdl.promise().current_value;
+        return hdl.promise().current_value.get();
       }
       iterator& operator++() { // pre-incrementable
         getNext();
@@ -153,6 +770,9 @@ namespace coro {
        ++*this;
       }
       bool operator==(const iterator& i) const = default;
+      bool operator==(std::default_sentinel_t) const noexcept {
+        return !hdl; // reached the end of the sequence
+      }
     };
 
     iterator begin() const {
@@ -160,45 +780,110 @@ namespace coro {
         return iterator{nullptr};
       }
       iterator itr{coro};
-      itr.getNext();
+      if (peeked) { // begins at the peeked value
+        peeked = false;
+      } else {
+        itr.getNext();
+      }
       return itr;
     }
 
-    iterator end() const {
-      return iterator{nullptr};
+    std::default_sentinel_t end() const noexcept {
+      return std::default_sentinel;
     }
   };
 
+  // a generator whose coroutine frame allocation the compiler may elide
+  template<typename T, exception_policy ExceptionPolicy = propagate_exceptions>
+  using elidable_generator = generator<T, ExceptionPolicy, elidable_allocation>;
+
+  // a generator whose coroutine frame is recycled by the thread once it is destroyed
+  template<typename T, exception_policy ExceptionPolicy = propagate_exceptions>
+  using reusable_generator = generator<T, ExceptionPolicy, recycling_allocation>;
+
   /**
-   * Helper class for establishing a pmr memory_resource compliant
-   * allocator that allocates from a supplied fixed size buffer, e.g.,
-   * such as a buffer allocated on the stack. Allocations are not
-   * freed so depends on buffer context being reclaimed when going
-   * out of scope (this class does not take ownership of the buffer).
+   * Helper class for establishing a pmr memory_resource compliant monotonic
+   * (bump) allocator that carves allocations, honouring the requested alignment,
+   * from a supplied buffer, e.g., a buffer allocated on the stack or in the data
+   * segment (this class does not take ownership of the buffer).
+   *
+   * Individual deallocations are not returned to the buffer, except for the most
+   * recent allocation (LIFO order, as when short-lived generators are created and
+   * destroyed one after another). Instead, the whole buffer can be recycled via
+   * reset(), or back to a point obtained from mark() via rewind(). When the buffer
+   * is exhausted, allocations fall back to the upstream memory resource, and such
+   * allocations are deallocated back to the upstream resource.
    */
-  class fixed_buffer_pmr_allocator : public std::pmr::memory_resource {
+  class bump_arena_pmr_allocator : public std::pmr::memory_resource {
+  public:
+    using marker = size_t; // an offset into the buffer as returned by mark()
   private:
-    void * const buf;
-    size_t buf_size;
+    std::byte * const buf;
+    size_t offset{0};
+    std::pmr::memory_resource * const upstream;
   public:
     const size_t max_buf_size;
-    fixed_buffer_pmr_allocator(void* buf, size_t buf_size) : buf(buf), buf_size(buf_size), max_buf_size(buf_size) {}
-    fixed_buffer_pmr_allocator() = delete;
-    fixed_buffer_pmr_allocator(const fixed_buffer_pmr_allocator&) = delete;
-    fixed_buffer_pmr_allocator(fixed_buffer_pmr_allocator&&) = delete;
-    fixed_buffer_pmr_allocator& operator=(const fixed_buffer_pmr_allocator&) = delete;
-    fixed_buffer_pmr_allocator& operator=(fixed_buffer_pmr_allocator&&) = delete;
+    bump_arena_pmr_allocator(void* buf, size_t buf_size,
+                             std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : buf(static_cast<std::byte*>(buf)), upstream(upstream), max_buf_size(buf_size)
+    {
+      assert(upstream != nullptr);
+    }
+    bump_arena_pmr_allocator() = delete;
+    bump_arena_pmr_allocator(const bump_arena_pmr_allocator&) = delete;
+    bump_arena_pmr_allocator(bump_arena_pmr_allocator&&) = delete;
+    bump_arena_pmr_allocator& operator=(const bump_arena_pmr_allocator&) = delete;
+    bump_arena_pmr_allocator& operator=(bump_arena_pmr_allocator&&) = delete;
+
+    size_t bytes_used() const noexcept { return offset; }
+    size_t bytes_remaining() const noexcept { return max_buf_size - offset; }
+    std::pmr::memory_resource* upstream_resource() const noexcept { return upstream; }
+
+    marker mark() const noexcept { return offset; }
+    void rewind(marker m) noexcept {
+      assert(m <= offset); // can only rewind back to an earlier mark
+      offset = m;
+    }
+    void reset() noexcept { offset = 0; }
+
   private:
-    virtual void* do_allocate(size_t bytes, size_t alignment) {
-      if (bytes > buf_size) {
-        std::cerr << "requested bytes: " << bytes << ", remaining bytes capacity: " << buf_size << '\n';
-        throw std::bad_alloc();
+    bool owns(const void* p) const noexcept {
+      const auto addr = reinterpret_cast<std::uintptr_t>(p);
+      const auto base = reinterpret_cast<std::uintptr_t>(buf);
+      return addr >= base && addr < base + max_buf_size;
+    }
+    void* do_allocate(size_t bytes, size_t alignment) override {
+      const auto base = reinterpret_cast<std::uintptr_t>(buf);
+      const auto aligned = (base + offset + (alignment - 1)) & ~(std::uintptr_t(alignment) - 1);
+      const size_t start = aligned - base;
+      if (start > max_buf_size || bytes > max_buf_size - start) {
+        return upstream->allocate(bytes, alignment); // buffer exhausted
+      }
+      offset = start + bytes;
+      return buf + start;
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+      if (!owns(p)) {
+        upstream->deallocate(p, bytes, alignment);
+      } else if (static_cast<std::byte*>(p) + bytes == buf + offset) {
+        offset = static_cast<std::byte*>(p) - buf; // reclaim most recent allocation
       }
-      buf_size -= bytes;
-      return buf;
     }
-    virtual void do_deallocate(void* p, size_t bytes, size_t alignment) {}
-    virtual bool do_is_equal(const memory_resource& __other) const noexcept { return false; }
+    bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+  };
+
+  /**
+   * Helper class for establishing a pmr memory_resource compliant
+   * allocator that allocates from a supplied fixed size buffer, e.g.,
+   * such as a buffer allocated on the stack. It is a bump arena that
+   * has no upstream fallback - when the buffer is exhausted then
+   * std::bad_alloc is thrown (this class does not take ownership of
+   * the buffer).
+   */
+  class fixed_buffer_pmr_allocator : public bump_arena_pmr_allocator {
+  public:
+    fixed_buffer_pmr_allocator(void* buf, size_t buf_size)
+      : bump_arena_pmr_allocator(buf, buf_size, std::pmr::null_memory_resource()) {}
   };
 
 } // namespace coro
@@ -0,0 +1,80 @@
+/** halo_check.cpp
+ *
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Licensed under the MIT License - refer to LICENSE project document.
+ *
+ * Reports whether the compiler elided the heap allocation of the coroutine frame
+ * (HALO) of a fibonacci() generator that does not escape the scope of its caller,
+ * by counting calls of the (replaced) global operator new. Only generators of the
+ * elidable_allocation policy are candidates for elision, as the frames of the
+ * default pmr_allocation policy are allocated via a pmr memory_resource pointer.
+ *
+ * Built with -O2 (refer to CMakeLists.txt), as no compiler elides at -O0.
+ */
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include "generator.h"
+#include "sequences.h"
+
+static std::atomic<std::size_t> global_new_calls{0};
+
+void* operator new(std::size_t sz) {
+  global_new_calls.fetch_add(1, std::memory_order_relaxed);
+  if (auto p = std::malloc(sz > 0 ? sz : 1)) return p;
+  throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// counts the frame allocations of the pmr_allocation policy
+class counting_resource : public std::pmr::memory_resource {
+public:
+  std::size_t allocations = 0;
+private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+};
+
+template<typename Generator>
+[[gnu::noinline]] unsigned long sum_fibonacci(const unsigned long ceiling) {
+  unsigned long sum = 0;
+  for (auto gen = fibonacci<unsigned long, Generator>(ceiling); gen.next(); ) {
+    sum += gen.getValueRef();
+  }
+  return sum;
+}
+
+template<typename Generator>
+std::size_t allocations_per_call(const char* name) {
+  constexpr int calls = 1'000;
+  const auto ceiling = std::numeric_limits<unsigned long>::max() / 1'000ul;
+  counting_resource pmr_allocations;
+  coro::set_pmr_mem_pool(&pmr_allocations);
+  const auto before = global_new_calls.load(std::memory_order_relaxed);
+  volatile unsigned long sink = 0;
+  for (int i = 0; i < calls; i++) {
+    sink = sink + sum_fibonacci<Generator>(ceiling);
+  }
+  const auto heap_allocations = global_new_calls.load(std::memory_order_relaxed) - before + pmr_allocations.allocations;
+  coro::reset_default_pmr_mem_pool();
+  const auto per_call = heap_allocations / calls;
+  std::cout << name << ": " << per_call << " heap allocation(s) per call - "
+            << (per_call == 0 ? "frame allocation elided" : "frame allocation not elided") << '\n';
+  return per_call;
+}
+
+int main() {
+  allocations_per_call<coro::generator<unsigned long>>("fibonacci() as coro::generator<unsigned long>");
+  allocations_per_call<coro::elidable_generator<unsigned long>>("fibonacci() as coro::elidable_generator<unsigned long>");
+}
@@ -0,0 +1,478 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Opt-in instrumentation of generators: per generator function (keyed by call
+ * site, as in frame_stats.h) the number of resumes and yields, the time spent
+ * inside the coroutine body versus in the consumer between resumes, and a
+ * histogram of the resume latency; and per pmr memory_resource the coroutine
+ * frame bytes allocated and freed. Enable by defining CORO_INSTRUMENTATION prior
+ * to including generator.h - otherwise the hooks are empty and compile away
+ * entirely, i.e., generator::next() compiles to the same code as it would
+ * without them.
+ *
+ * The counters are kept per thread (written by their thread only, so without
+ * any atomic read-modify-write) and are only aggregated on demand, by
+ * collect_instrumentation(), which can be dumped as Prometheus text or JSON.
+ */
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace coro {
+
+  // bucket k of the resume latency histogram counts resumes of less than 2^k nanoseconds
+  // (and of at least 2^(k-1) nanoseconds), the last bucket also counts any longer ones
+  inline constexpr std::size_t latency_buckets = 32;
+
+  struct generator_site_stats {
+    std::string function_name;
+    std::string file_name;
+    std::uint_least32_t line;
+    std::uint64_t resumes;     // by the consumer (of the outermost generator, if nested)
+    std::uint64_t yields;      // values yielded by the coroutine body
+    std::uint64_t body_ns;     // time spent inside the coroutine body, i.e., resumed
+    std::uint64_t consumer_ns; // time spent by the consumer between resumes
+    std::array<std::uint64_t, latency_buckets> resume_latency; // histogram (refer to latency_buckets)
+  };
+
+  struct frame_resource_stats {
+    const std::pmr::memory_resource* resource;
+    std::string name; // as given to name_frame_resource(), else the address of the resource
+    std::uint64_t allocations;
+    std::uint64_t allocated_bytes;
+    std::uint64_t deallocations;
+    std::uint64_t deallocated_bytes;
+  };
+
+  struct instrumentation_snapshot {
+    std::vector<generator_site_stats> generators;
+    std::vector<frame_resource_stats> frame_resources;
+  };
+
+  namespace detail {
+    inline constexpr std::size_t max_instrumented_sites = 64;    // further call sites share the last one
+    inline constexpr std::size_t max_instrumented_resources = 32; // further resources share the last one
+
+    using counter = std::atomic<std::uint64_t>;
+
+    // only the owning thread writes to its counters, whereas any thread may read them
+    inline void bump(counter& c, std::uint64_t n = 1) noexcept {
+      c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    struct site_counters {
+      counter resumes{0};
+      counter yields{0};
+      counter body_ns{0};
+      counter consumer_ns{0};
+      std::array<counter, latency_buckets> resume_latency{};
+    };
+
+    struct resource_counters {
+      std::atomic<const std::pmr::memory_resource*> resource{nullptr};
+      counter allocations{0};
+      counter allocated_bytes{0};
+      counter deallocations{0};
+      counter deallocated_bytes{0};
+    };
+
+    struct thread_counters {
+      std::array<site_counters, max_instrumented_sites> sites{};
+      std::array<resource_counters, max_instrumented_resources> resources{};
+
+      resource_counters& of(const std::pmr::memory_resource* mr) noexcept {
+        for (std::size_t i = 0; i < resources.size() - 1; i++) {
+          auto r = resources[i].resource.load(std::memory_order_relaxed);
+          if (r == mr) return resources[i];
+          if (r == nullptr) {
+            resources[i].resource.store(mr, std::memory_order_release);
+            return resources[i];
+          }
+        }
+        return resources.back();
+      }
+    };
+
+    // the counters of a thread, which are registered for as long as the thread lives
+    struct registered_thread_counters : thread_counters {
+      registered_thread_counters();
+      ~registered_thread_counters();
+    };
+
+    struct site_info {
+      std::string function_name;
+      std::string file_name;
+      std::uint_least32_t line;
+    };
+
+    /**
+     * Registry of the instrumented call sites and of the counters of the threads, which
+     * folds the counters of a thread into those of the (exited) threads as it exits.
+     */
+    class instrumentation_registry {
+    private:
+      mutable std::mutex mtx;
+      std::vector<site_info> sites;
+      std::vector<thread_counters*> threads;
+      std::unordered_map<const std::pmr::memory_resource*, std::string> resource_names;
+      std::unique_ptr<thread_counters> exited; // counters of exited threads
+      friend struct registered_thread_counters;
+
+      template<typename F>
+      void for_each_counters(F&& f) const {
+        for (const auto* tc : threads) f(*tc);
+        if (exited) f(*exited);
+      }
+
+      static void fold(const thread_counters& from, thread_counters& into) noexcept {
+        for (std::size_t i = 0; i < max_instrumented_sites; i++) {
+          auto& s = from.sites[i];
+          auto& d = into.sites[i];
+          bump(d.resumes, s.resumes.load(std::memory_order_relaxed));
+          bump(d.yields, s.yields.load(std::memory_order_relaxed));
+          bump(d.body_ns, s.body_ns.load(std::memory_order_relaxed));
+          bump(d.consumer_ns, s.consumer_ns.load(std::memory_order_relaxed));
+          for (std::size_t k = 0; k < latency_buckets; k++) {
+            bump(d.resume_latency[k], s.resume_latency[k].load(std::memory_order_relaxed));
+          }
+        }
+        for (const auto& s : from.resources) {
+          auto mr = s.resource.load(std::memory_order_acquire);
+          if (mr == nullptr) continue;
+          auto& d = into.of(mr);
+          bump(d.allocations, s.allocations.load(std::memory_order_relaxed));
+          bump(d.allocated_bytes, s.allocated_bytes.load(std::memory_order_relaxed));
+          bump(d.deallocations, s.deallocations.load(std::memory_order_relaxed));
+          bump(d.deallocated_bytes, s.deallocated_bytes.load(std::memory_order_relaxed));
+        }
+      }
+    public:
+      std::uint32_t site_id(const std::source_location& loc) {
+        std::lock_guard<std::mutex> lk{mtx};
+        auto it = std::find_if(sites.begin(), sites.end(), [&loc](const site_info& s) {
+          return s.line == loc.line() && s.function_name == loc.function_name() && s.file_name == loc.file_name();
+        });
+        if (it == sites.end()) {
+          if (sites.size() == max_instrumented_sites) return max_instrumented_sites - 1;
+          sites.push_back({loc.function_name(), loc.file_name(), loc.line()});
+          it = std::prev(sites.end());
+        }
+        return static_cast<std::uint32_t>(it - sites.begin());
+      }
+
+      void name_resource(const std::pmr::memory_resource* mr, std::string name) {
+        std::lock_guard<std::mutex> lk{mtx};
+        resource_names[mr] = std::move(name);
+      }
+
+      instrumentation_snapshot snapshot() const {
+        std::lock_guard<std::mutex> lk{mtx};
+        instrumentation_snapshot snap;
+        for (std::size_t i = 0; i < sites.size(); i++) {
+          generator_site_stats stats{sites[i].function_name, sites[i].file_name, sites[i].line, 0, 0, 0, 0, {}};
+          for_each_counters([&stats, i](const thread_counters& tc) {
+            auto& s = tc.sites[i];
+            stats.resumes += s.resumes.load(std::memory_order_relaxed);
+            stats.yields += s.yields.load(std::memory_order_relaxed);
+            stats.body_ns += s.body_ns.load(std::memory_order_relaxed);
+            stats.consumer_ns += s.consumer_ns.load(std::memory_order_relaxed);
+            for (std::size_t k = 0; k < latency_buckets; k++) {
+              stats.resume_latency[k] += s.resume_latency[k].load(std::memory_order_relaxed);
+            }
+          });
+          snap.generators.push_back(std::move(stats));
+        }
+        for_each_counters([&snap, this](const thread_counters& tc) {
+          for (const auto& s : tc.resources) {
+            auto mr = s.resource.load(std::memory_order_acquire);
+            if (mr == nullptr) continue;
+            auto it = std::find_if(snap.frame_resources.begin(), snap.frame_resources.end(),
+                                   [mr](const frame_resource_stats& r) { return r.resource == mr; });
+            if (it == snap.frame_resources.end()) {
+              auto name = resource_names.find(mr);
+              snap.frame_resources.push_back({mr, name != resource_names.end() ? name->second : address_of(mr), 0, 0, 0, 0});
+              it = std::prev(snap.frame_resources.end());
+            }
+            it->allocations += s.allocations.load(std::memory_order_relaxed);
+            it->allocated_bytes += s.allocated_bytes.load(std::memory_order_relaxed);
+            it->deallocations += s.deallocations.load(std::memory_order_relaxed);
+            it->deallocated_bytes += s.deallocated_bytes.load(std::memory_order_relaxed);
+          }
+        });
+        return snap;
+      }
+
+      static instrumentation_registry& instance() {
+        static instrumentation_registry registry;
+        return registry;
+      }
+
+    private:
+      static std::string address_of(const void* p) {
+        constexpr char digits[] = "0123456789abcdef";
+        auto v = reinterpret_cast<std::uintptr_t>(p);
+        std::string s;
+        do {
+          s.insert(s.begin(), digits[v & 0xf]);
+          v >>= 4;
+        } while (v != 0);
+        return "0x" + s;
+      }
+    };
+
+    inline registered_thread_counters::registered_thread_counters() {
+      auto& registry = instrumentation_registry::instance();
+      std::lock_guard<std::mutex> lk{registry.mtx};
+      registry.threads.push_back(this);
+    }
+
+    inline registered_thread_counters::~registered_thread_counters() {
+      auto& registry = instrumentation_registry::instance();
+      std::lock_guard<std::mutex> lk{registry.mtx};
+      std::erase(registry.threads, this);
+      if (!registry.exited) {
+        registry.exited = std::make_unique<thread_counters>();
+      }
+      instrumentation_registry::fold(*this, *registry.exited);
+    }
+  } // namespace detail
+
+  /**
+   * Aggregates the counters of all the threads (including those that have exited).
+   * Empty unless CORO_INSTRUMENTATION is defined.
+   */
+  inline instrumentation_snapshot collect_instrumentation() {
+    return detail::instrumentation_registry::instance().snapshot();
+  }
+
+  // labels the frame allocations from the specified memory resource in the dumps
+  inline void name_frame_resource(const std::pmr::memory_resource* mr, std::string name) {
+    detail::instrumentation_registry::instance().name_resource(mr, std::move(name));
+  }
+
+  namespace detail {
+    inline void write_escaped(std::ostream& os, std::string_view s) {
+      for (const char c : s) {
+        switch (c) {
+          case '\\': os << "\\\\"; break;
+          case '"':  os << "\\\""; break;
+          case '\n': os << "\\n"; break;
+          default:   os << c;
+        }
+      }
+    }
+
+    inline void write_seconds(std::ostream& os, std::uint64_t ns) {
+      os << static_cast<double>(ns) * 1e-9;
+    }
+  } // namespace detail
+
+  /**
+   * Writes the snapshot in the Prometheus text exposition format, e.g.:
+   *   coro_generator_resumes_total{function="...",file="...",line="42"} 1000
+   */
+  inline void write_prometheus(std::ostream& os, const instrumentation_snapshot& snap) {
+    const auto write_site_labels = [&os](const generator_site_stats& g) {
+      os << "{function=\"";
+      detail::write_escaped(os, g.function_name);
+      os << "\",file=\"";
+      detail::write_escaped(os, g.file_name);
+      os << "\",line=\"" << g.line << '"';
+    };
+    const auto write_site_counter = [&](const char* name, const char* help, auto value) {
+      os << "# HELP " << name << ' ' << help << "\n# TYPE " << name << " counter\n";
+      for (const auto& g : snap.generators) {
+        os << name;
+        write_site_labels(g);
+        os << "} " << value(g) << '\n';
+      }
+    };
+    write_site_counter("coro_generator_resumes_total", "Number of times the consumer resumed the generator.",
+                       [](const generator_site_stats& g) { return g.resumes; });
+    write_site_counter("coro_generator_yields_total", "Number of values yielded by the coroutine body.",
+                       [](const generator_site_stats& g) { return g.yields; });
+    write_site_counter("coro_generator_body_seconds_total", "Time spent inside the coroutine body.",
+                       [](const generator_site_stats& g) { return static_cast<double>(g.body_ns) * 1e-9; });
+    write_site_counter("coro_generator_consumer_seconds_total", "Time spent by the consumer between resumes.",
+                       [](const generator_site_stats& g) { return static_cast<double>(g.consumer_ns) * 1e-9; });
+
+    os << "# HELP coro_generator_resume_latency_seconds Time taken by a resume of the generator.\n"
+          "# TYPE coro_generator_resume_latency_seconds histogram\n";
+    for (const auto& g : snap.generators) {
+      std::uint64_t cumulative = 0;
+      for (std::size_t k = 0; k < latency_buckets - 1; k++) {
+        cumulative += g.resume_latency[k];
+        os << "coro_generator_resume_latency_seconds_bucket";
+        write_site_labels(g);
+        os << ",le=\"";
+        detail::write_seconds(os, std::uint64_t{1} << k);
+        os << "\"} " << cumulative << '\n';
+      }
+      os << "coro_generator_resume_latency_seconds_bucket";
+      write_site_labels(g);
+      os << ",le=\"+Inf\"} " << g.resumes << '\n';
+      os << "coro_generator_resume_latency_seconds_sum";
+      write_site_labels(g);
+      os << "} ";
+      detail::write_seconds(os, g.body_ns);
+      os << "\ncoro_generator_resume_latency_seconds_count";
+      write_site_labels(g);
+      os << "} " << g.resumes << '\n';
+    }
+
+    const auto write_resource_counter = [&](const char* name, const char* help, auto value) {
+      os << "# HELP " << name << ' ' << help << "\n# TYPE " << name << " counter\n";
+      for (const auto& r : snap.frame_resources) {
+        os << name << "{resource=\"";
+        detail::write_escaped(os, r.name);
+        os << "\"} " << value(r) << '\n';
+      }
+    };
+    write_resource_counter("coro_frame_allocations_total", "Number of coroutine frames allocated.",
+                           [](const frame_resource_stats& r) { return r.allocations; });
+    write_resource_counter("coro_frame_allocated_bytes_total", "Bytes of coroutine frames allocated.",
+                           [](const frame_resource_stats& r) { return r.allocated_bytes; });
+    write_resource_counter("coro_frame_deallocations_total", "Number of coroutine frames freed.",
+                           [](const frame_resource_stats& r) { return r.deallocations; });
+    write_resource_counter("coro_frame_deallocated_bytes_total", "Bytes of coroutine frames freed.",
+                           [](const frame_resource_stats& r) { return r.deallocated_bytes; });
+  }
+
+  // writes the snapshot as a JSON object of "generators" and "frame_resources" arrays
+  inline void write_json(std::ostream& os, const instrumentation_snapshot& snap) {
+    const auto write_string = [&os](std::string_view s) {
+      os << '"';
+      for (const unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+          os << '\\' << c;
+        } else if (c < 0x20) {
+          constexpr char digits[] = "0123456789abcdef";
+          os << "\\u00" << digits[c >> 4] << digits[c & 0xf];
+        } else {
+          os << c;
+        }
+      }
+      os << '"';
+    };
+    os << "{\"generators\":[";
+    for (std::size_t i = 0; i < snap.generators.size(); i++) {
+      const auto& g = snap.generators[i];
+      os << (i > 0 ? "," : "") << "{\"function\":";
+      write_string(g.function_name);
+      os << ",\"file\":";
+      write_string(g.file_name);
+      os << ",\"line\":" << g.line << ",\"resumes\":" << g.resumes << ",\"yields\":" << g.yields
+         << ",\"body_ns\":" << g.body_ns << ",\"consumer_ns\":" << g.consumer_ns << ",\"resume_latency_log2_ns\":[";
+      for (std::size_t k = 0; k < latency_buckets; k++) {
+        os << (k > 0 ? "," : "") << g.resume_latency[k];
+      }
+      os << "]}";
+    }
+    os << "],\"frame_resources\":[";
+    for (std::size_t i = 0; i < snap.frame_resources.size(); i++) {
+      const auto& r = snap.frame_resources[i];
+      os << (i > 0 ? "," : "") << "{\"resource\":";
+      write_string(r.name);
+      os << ",\"allocations\":" << r.allocations << ",\"allocated_bytes\":" << r.allocated_bytes
+         << ",\"deallocations\":" << r.deallocations << ",\"deallocated_bytes\":" << r.deallocated_bytes << '}';
+    }
+    os << "]}";
+  }
+
+  namespace detail {
+#ifdef CORO_INSTRUMENTATION
+    inline thread_local registered_thread_counters this_thread_counters{};
+
+    inline std::uint64_t instrumentation_clock() noexcept {
+      return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    inline void note_frame_resource_allocate(const std::pmr::memory_resource* mr, std::size_t bytes) noexcept {
+      auto& r = this_thread_counters.of(mr);
+      bump(r.allocations);
+      bump(r.allocated_bytes, bytes);
+    }
+    inline void note_frame_resource_deallocate(const std::pmr::memory_resource* mr, std::size_t bytes) noexcept {
+      auto& r = this_thread_counters.of(mr);
+      bump(r.deallocations);
+      bump(r.deallocated_bytes, bytes);
+    }
+
+    /**
+     * Base class of promise types that records the resumes and yields of the generator
+     * into the counters of its call site, on the resuming thread.
+     */
+    struct promise_instrumentation {
+    private:
+      std::uint32_t site = 0;
+      std::uint64_t suspended_at = 0; // when the coroutine last suspended (0 before its first resume)
+    public:
+      void instrument_site(const std::source_location& loc) {
+        // cached per thread, keyed by the (static) function name, so the registry is only locked once
+        static thread_local std::unordered_map<const char*, std::uint32_t> site_ids;
+        auto [it, inserted] = site_ids.try_emplace(loc.function_name(), 0);
+        if (inserted) {
+          it->second = instrumentation_registry::instance().site_id(loc);
+        }
+        site = it->second;
+      }
+      std::uint64_t before_resume() noexcept {
+        const auto now = instrumentation_clock();
+        if (suspended_at != 0) {
+          bump(this_thread_counters.sites[site].consumer_ns, now - suspended_at);
+        }
+        return now;
+      }
+      void after_resume(std::uint64_t resumed_at) noexcept {
+        const auto now = instrumentation_clock();
+        const auto latency = now - resumed_at;
+        auto& counters = this_thread_counters.sites[site];
+        bump(counters.resumes);
+        bump(counters.body_ns, latency);
+        bump(counters.resume_latency[std::min<std::size_t>(std::bit_width(latency), latency_buckets - 1)]);
+        suspended_at = now;
+      }
+      void on_yield() noexcept {
+        bump(this_thread_counters.sites[site].yields);
+      }
+    };
+
+    // by how much the instrumentation enlarges a promise
+    inline constexpr std::size_t promise_instrumentation_size = sizeof(promise_instrumentation);
+#else
+    constexpr void note_frame_resource_allocate(const std::pmr::memory_resource*, std::size_t) noexcept {}
+    constexpr void note_frame_resource_deallocate(const std::pmr::memory_resource*, std::size_t) noexcept {}
+
+    struct promise_instrumentation {
+      struct no_timestamp {};
+      static constexpr void instrument_site(const std::source_location&) noexcept {}
+      static constexpr no_timestamp before_resume() noexcept { return {}; }
+      static constexpr void after_resume(no_timestamp) noexcept {}
+      static constexpr void on_yield() noexcept {}
+    };
+
+    inline constexpr std::size_t promise_instrumentation_size = 0; // an empty base
+#endif
+  } // namespace detail
+
+} // namespace coro
+
+#endif //INSTRUMENTATION_H
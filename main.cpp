@@ -13,58 +13,20 @@
  * SFINAE type traits. The current implementation has been verified via
  * gcc/g++ v12.1 and with clang++ v16.
  */
+#define CORO_FRAME_SIZE_STATS // record the frame size of each generator function (refer to frame_stats.h)
 #include <limits>
 #include <iostream>
 #include <algorithm>
+#include <memory>
+#include <assert.h>
 #include "generator.h" // general purpose C++20 coroutine generator template class
+#include "sequences.h" // the ascending_sequence() and fibonacci() generator functions (and checkpointable ones)
 
 static const auto demo_ceiling1 = std::numeric_limits<unsigned long>::max() / 1'000ul;
 static const auto demo_ceiling2 = std::numeric_limits<unsigned long long>::max() / 1'000ul;
 static const auto demo_ceiling3 = std::numeric_limits<double>::max() / 1'000.0f;
 static const auto demo_ceiling4 = std::numeric_limits<long double>::max() / 1'000.0f;
 
-// concept to constrain function templates that follow to only accept arithmetic types
-template <typename T>
-concept arithmetic = std::integral<T> || std::floating_point<T>;
-
-/**
- * Returns number in ascending sequence starting at specified value.
- *
- * @tparam T arithmetic type of number returned
- * @param start value to begin sequence at
- * @return coroutine task iterator
- */
-template<arithmetic T>
-coro::generator<T> ascending_sequence(const T start) {
-  T i = start;
-  while (true) {
-    T j = i++;
-    co_yield j;
-  }
-}
-
-/**
- * Generates Fibonacci sequence up to specified ceiling value.
- *
- * @tparam T arithmetic type of number returned
- * @param ceiling terminates generation of sequence when reaching
- * @return coroutine task iterator
- */
-template<arithmetic T>
-coro::generator<T> fibonacci(const T ceiling) {
-  T j = 0;
-  T i = 1;
-  co_yield j;
-  if (ceiling > j) {
-    do {
-      co_yield i;
-      T tmp = i;
-      i += j;
-      j = tmp;
-    } while (i <= ceiling);
-  }
-}
-
 // C++ (C++17 fold expressions)
 template <class T>
 void print_one(T &&arg) {
@@ -75,6 +37,12 @@ void print(Ts &&... args) {
   (print_one(std::forward<Ts>(args)), ...);
 }
 
+// yields the elements of the inner generator, beginning with its peeked value, if any
+template <class T>
+coro::generator<T> elements_of_inner(coro::generator<T> &inner) {
+  co_yield coro::elements_of(inner);
+}
+
 int main() {
   std::cout << "Example using C++20 coroutines to implement Simple Integer and Fibonacci Sequence generators" << '\n';
 
@@ -83,16 +51,23 @@ int main() {
   std::cerr << sizeof(coro_gen_ints_promise_type) << " bytes : coro::generator<int>::promise_type\n";
   std::cerr << sizeof(coro_gen_ints) << " bytes : coro::generator<int>\n";
 
+  // measure the frame size of the generator functions (the sizeof promise_type is insufficient),
+  // by instantiating each once from the default allocator, so the stack buffers can be sized to fit
+  { auto probe = ascending_sequence(0); }
+  { auto probe = fibonacci(demo_ceiling4); }
+  auto const& frame_sizes = coro::frame_size_registry::instance();
+  for (const auto& r : frame_sizes.snapshot()) {
+    std::cerr << r.allocation_size << " bytes : frame of " << r.function_name << '\n';
+  }
+
   // insure instantiation of a decltype(0) coro::generator promise_type is on the stack - not the heap
-  std::cerr << "set coro::generator<int> to stack memory buffer pmr allocator\n";
-//  size_t buf_size = sizeof(coro_gen_ints_promise_type);
-  size_t buf_size = 64; // allocating sizeof promise_type is insufficient for g++
+  std::cerr << "allocate coro::generator<int> from stack memory buffer pmr allocator\n";
+  size_t buf_size = coro::frame_buffer_size(frame_sizes.max_allocation_size({"ascending_sequence", "T = int"}));
   coro::fixed_buffer_pmr_allocator pmr_alloc{ alloca(buf_size), buf_size };
-  coro::set_pmr_mem_pool(&pmr_alloc);
 
   std::cout << '\n' << "Simple Integer Sequence Generator" << '\n' << ' ';
   try {
-    auto iter1 = ascending_sequence(0);
+    auto iter1 = ascending_sequence(std::allocator_arg, &pmr_alloc, 0);
     for(int i = 1; i <= 10 && iter1.next(); i++) {
       const auto value = iter1.getValue().value();
       print(i, ": bytes", sizeof(value), ':', value, '\n');
@@ -127,21 +102,11 @@ int main() {
   std::cerr << sizeof(coro_gen_ldoubles_promise_type) << " bytes : coro::generator<long double>::promise_type\n";
   std::cerr << sizeof(coro_gen_ldoubles) << " bytes : coro::generator<long double>\n";
 
-  // reset the coro::generator class to the default promise_type allocator (global new and delete)
-  std::cerr << "reset coro::generator to default pmr allocator (global new and delete)\n";
-  coro::reset_default_pmr_mem_pool();
-
   auto const invoke_fib_seq = [](auto&& iter) {
     std::cout << '\n' << "Fibonacci Sequence Generator" << '\n' << ' ';
-    try {
-      for (int i = 1; iter.next(); i++) {
-        const auto value = iter.getValue().value();
-        print(i, ": bytes", sizeof(value), ':', value, '\n');
-      }
-    } catch(const std::bad_optional_access& e) {
-      // calling iter.next() with true result prior to calling iter.getValue().value()
-      // should insure a value is always returned, so should never reach here
-      std::cerr << e.what() << '\n';
+    for (int i = 1; iter.next(); i++) {
+      const auto &value = iter.getValueRef(); // zero-copy access to the yielded value
+      print(i, ": bytes", sizeof(value), ':', value, '\n');
     }
   };
 
@@ -149,33 +114,51 @@ int main() {
   invoke_fib_seq(fibonacci(demo_ceiling2));
   invoke_fib_seq(fibonacci(demo_ceiling3));
 
-  std::cerr << "now set coro::generator<long double> to stack memory buffer pmr allocator\n";
+  std::cerr << "now allocate coro::generator<long double> from stack memory buffer pmr allocator\n";
   // insure instantiation of a decltype(demo_ceiling4) coro::generator promise_type is on the stack - not the heap
-//  buf_size = sizeof(coro_gen_ldoubles_promise_type);
-  buf_size = 256; // allocating sizeof promise_type is insufficient for g++
-  coro::fixed_buffer_pmr_allocator pmr_alloc_ldbl{ alloca(buf_size), buf_size };
-  coro::set_pmr_mem_pool(&pmr_alloc_ldbl);
-
-  try {
-    invoke_fib_seq(fibonacci(demo_ceiling4)); // instantiates a coro::generator fibonacci for decltype(demo_ceiling4)
-  } catch(const std::bad_alloc& e) {
-    // only reaches here if stack buffer was insufficient for allocating the coro::generator promise_type context
-    std::cerr << e.what() << '\n';
-  }
+  buf_size = coro::frame_buffer_size(frame_sizes.max_allocation_size({"fibonacci", "T = long double"}));
+  // the bump arena falls back to the default allocator should the stack buffer be insufficient
+  coro::bump_arena_pmr_allocator pmr_alloc_ldbl{ alloca(buf_size), buf_size };
 
-  // reset the coro::generator class to the default promise_type allocator (global new and delete)
-  std::cerr << "reset coro::generator again to default pmr allocator (global new and delete)\n";
-  coro::reset_default_pmr_mem_pool();
+  const auto arena_mark = pmr_alloc_ldbl.mark();
+  // instantiates a coro::generator fibonacci for decltype(demo_ceiling4) - its frame is allocated from the arena
+  invoke_fib_seq(fibonacci(std::allocator_arg, &pmr_alloc_ldbl, demo_ceiling4));
+  pmr_alloc_ldbl.rewind(arena_mark); // recycle the stack buffer for any subsequent generators
 
   // use the generator's coroutine task iterator
   try {
     std::cout << '\n' << "Fibonacci Sequence Generator" << '\n' << ' ';
     auto rng = fibonacci(demo_ceiling1);
     static_assert(std::ranges::input_range<decltype(rng)>);
+    static_assert(std::ranges::view<decltype(rng)>);
     int i = 1;
     std::ranges::for_each(rng, [&i](const auto &value){ print(i++, ": bytes", sizeof(value), ':', value, '\n'); });
   } catch(const std::bad_optional_access& e) {
     // should never reach here
     std::cerr << e.what() << '\n';
   }
+
+  // snapshot a checkpointable generator mid-sequence, then resume a new one from the snapshot
+  std::cout << '\n' << "Checkpointed Fibonacci Sequence Generator" << '\n' << ' ';
+  auto fib_seq = checkpointable_fibonacci(demo_ceiling1);
+  int i = 1;
+  for (; i <= 10 && fib_seq.next(); i++) {
+    print(i, ": bytes", sizeof(fib_seq.getValueRef()), ':', fib_seq.getValueRef(), '\n');
+  }
+  const auto checkpoint = fib_seq.snapshot(); // e.g., as persisted prior to a restart
+  auto resumed_fib_seq = checkpointable_fibonacci(demo_ceiling1);
+  resumed_fib_seq.restore(checkpoint);
+  for (const auto &value : resumed_fib_seq) {
+    print(i++, ": bytes", sizeof(value), ':', value, '\n');
+  }
+
+  // peek at the first value of a generator, then yield all its elements from within another one
+  std::cout << '\n' << "Peeked Fibonacci Sequence Generator, nested via elements_of" << '\n' << ' ';
+  auto peeked_fib_seq = fibonacci(demo_ceiling1);
+  print("peeked:", *peeked_fib_seq.peek(), '\n');
+  i = 1;
+  for (const auto &value : elements_of_inner(peeked_fib_seq)) {
+    print(i++, ": bytes", sizeof(value), ':', value, '\n');
+  }
+  assert(!peeked_fib_seq.next()); // the peeked value was consumed by the outer generator
 }
\ No newline at end of file
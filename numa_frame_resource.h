@@ -0,0 +1,223 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * pmr memory_resource that carves coroutine frames from 2 MiB huge pages, each of
+ * which is bound to the NUMA node of the thread that needed it (Linux only), for
+ * programs with very many live generators: their frames then share few TLB entries
+ * and are local to the memory node of the CPUs that created them.
+ *
+ * The frames are carved per node, from free lists per size class (of 64 bytes, the
+ * blocks are cache-line aligned) and from the remainder of the node's current huge
+ * page. A huge page records its node arena in its first cache line, so a frame that
+ * is freed on a thread of another node is returned to its own node. An explicit
+ * huge page (hugetlbfs) is mapped where the system has reserved any; otherwise
+ * the mapping is aligned to 2 MiB and advised to be backed by a transparent huge
+ * page. Pages are only returned to the system when the resource is destroyed.
+ */
+#ifndef NUMA_FRAME_RESOURCE_H
+#define NUMA_FRAME_RESOURCE_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace coro {
+
+  namespace detail {
+
+    inline constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+    // selects huge pages of that size, i.e., MAP_HUGE_2MB (rather than the system's default huge page size)
+    inline constexpr int map_huge_page_size = std::countr_zero(huge_page_size) << MAP_HUGE_SHIFT;
+
+    // the NUMA node of the CPU that the calling thread currently runs on (0 where unknown)
+    inline unsigned this_thread_numa_node() noexcept {
+      unsigned cpu = 0;
+      unsigned node = 0;
+      return ::getcpu(&cpu, &node) == 0 ? node : 0;
+    }
+
+    /**
+     * Maps a 2 MiB huge page (whatever the size of the system's default huge pages, so
+     * that unmapping huge_page_size unmaps the whole page) aligned to its size, bound
+     * to the node - as the preferred node, so that an exhausted node falls back to the
+     * others instead of failing the page fault. Returns nullptr should the address
+     * space be exhausted.
+     */
+    inline void* map_huge_page(unsigned node) noexcept {
+      void* page = ::mmap(nullptr, huge_page_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | map_huge_page_size, -1, 0);
+      if (page == MAP_FAILED) { // no huge pages reserved - over-map, to trim to a huge page boundary
+        void* raw = ::mmap(nullptr, 2 * huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return nullptr;
+        const auto begin = reinterpret_cast<std::uintptr_t>(raw);
+        const auto aligned = (begin + huge_page_size - 1) & ~(huge_page_size - 1);
+        if (aligned > begin) {
+          ::munmap(raw, aligned - begin);
+        }
+        if (const auto excess = begin + huge_page_size - aligned; excess > 0) {
+          ::munmap(reinterpret_cast<void*>(aligned + huge_page_size), excess);
+        }
+        page = reinterpret_cast<void*>(aligned);
+        ::madvise(page, huge_page_size, MADV_HUGEPAGE); // best effort
+      }
+      if (node < 63) { // before the page is first touched (best effort, e.g., without NUMA support)
+        const unsigned long node_mask = 1ul << node;
+        ::syscall(SYS_mbind, page, huge_page_size, MPOL_PREFERRED, &node_mask, 64ul, 0u);
+      }
+      return page;
+    }
+
+    class numa_node_arena;
+
+    // the first cache line of each huge page
+    struct alignas(64) huge_page_header {
+      numa_node_arena* arena;
+      huge_page_header* next;
+    };
+
+    class numa_node_arena {
+    public:
+      static constexpr std::size_t size_class_granularity = 64;
+      static constexpr std::size_t num_size_classes = 64; // blocks of up to 4 KiB
+      static constexpr std::size_t no_size_class = num_size_classes;
+
+      static constexpr std::size_t size_class_of(std::size_t bytes, std::size_t alignment) noexcept {
+        if (alignment > size_class_granularity || bytes == 0) return no_size_class;
+        const std::size_t idx = (bytes - 1) / size_class_granularity;
+        return idx < num_size_classes ? idx : no_size_class;
+      }
+      static constexpr std::size_t block_size_of(std::size_t size_class) noexcept {
+        return (size_class + 1) * size_class_granularity;
+      }
+
+      static numa_node_arena& of(void* block) noexcept {
+        const auto page = reinterpret_cast<std::uintptr_t>(block) & ~(huge_page_size - 1);
+        return *reinterpret_cast<huge_page_header*>(page)->arena;
+      }
+    private:
+      struct free_node {
+        free_node* next;
+      };
+
+      const unsigned node;
+      std::mutex mtx;
+      free_node* free[num_size_classes]{};
+      std::byte* carve = nullptr; // the remainder of the current huge page
+      std::byte* carve_end = nullptr;
+      huge_page_header* pages = nullptr;
+    public:
+      explicit numa_node_arena(unsigned numa_node) noexcept : node{numa_node} {}
+      numa_node_arena(const numa_node_arena&) = delete;
+      numa_node_arena& operator=(const numa_node_arena&) = delete;
+      ~numa_node_arena() {
+        while (pages != nullptr) {
+          auto next = pages->next;
+          ::munmap(pages, huge_page_size);
+          pages = next;
+        }
+      }
+
+      void* allocate(std::size_t size_class) {
+        std::lock_guard<std::mutex> lk{mtx};
+        if (auto block = free[size_class]; block != nullptr) {
+          free[size_class] = block->next;
+          return block;
+        }
+        const auto block_size = block_size_of(size_class);
+        if (static_cast<std::size_t>(carve_end - carve) < block_size) { // the rest of the page is left unused
+          auto page = static_cast<huge_page_header*>(map_huge_page(node));
+          if (page == nullptr) throw std::bad_alloc{};
+          *page = huge_page_header{this, pages};
+          pages = page;
+          carve = reinterpret_cast<std::byte*>(page) + sizeof(huge_page_header);
+          carve_end = reinterpret_cast<std::byte*>(page) + huge_page_size;
+        }
+        void* block = carve;
+        carve += block_size;
+        return block;
+      }
+
+      void deallocate(void* p, std::size_t size_class) noexcept {
+        auto block = static_cast<free_node*>(p);
+        std::lock_guard<std::mutex> lk{mtx};
+        block->next = free[size_class];
+        free[size_class] = block;
+      }
+    };
+
+  } // namespace detail
+
+  /**
+   * pmr memory_resource that serves coroutine frames from huge pages bound to the
+   * NUMA node of the allocating thread, see above - e.g., via set_pmr_mem_pool(&res)
+   * or generator functions taking (std::allocator_arg, &res, ...). Allocations larger
+   * than 4 KiB, or aligned to more than a cache line, are forwarded to upstream.
+   * Each node arena is guarded by a mutex, so the frame_pool_resource (refer to
+   * frame_pool.h) remains the faster one to create and destroy generators with; this
+   * one is for resuming very many live generators. The resource must outlive the
+   * frames allocated from it.
+   */
+  class numa_hugepage_resource : public std::pmr::memory_resource {
+    using arena = detail::numa_node_arena;
+  public:
+    static constexpr std::size_t max_numa_nodes = 64;
+  private:
+    std::pmr::memory_resource* const upstream;
+    std::atomic<arena*> arenas[max_numa_nodes]{};
+
+    arena& arena_of(unsigned node) {
+      auto& slot = arenas[node % max_numa_nodes];
+      auto a = slot.load(std::memory_order_acquire);
+      if (a == nullptr) [[unlikely]] {
+        auto created = new arena{node};
+        if (slot.compare_exchange_strong(a, created, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          a = created;
+        } else {
+          delete created; // another thread of the node was first
+        }
+      }
+      return *a;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+      const auto size_class = arena::size_class_of(bytes, alignment);
+      if (size_class == arena::no_size_class) {
+        return upstream->allocate(bytes, alignment);
+      }
+      return arena_of(detail::this_thread_numa_node()).allocate(size_class);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+      const auto size_class = arena::size_class_of(bytes, alignment);
+      if (size_class == arena::no_size_class) {
+        upstream->deallocate(p, bytes, alignment);
+        return;
+      }
+      arena::of(p).deallocate(p, size_class); // back to the node it was allocated on
+    }
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  public:
+    explicit numa_hugepage_resource(std::pmr::memory_resource* upstream_resource = std::pmr::new_delete_resource())
+      : upstream{upstream_resource} {}
+    numa_hugepage_resource(const numa_hugepage_resource&) = delete;
+    numa_hugepage_resource& operator=(const numa_hugepage_resource&) = delete;
+    ~numa_hugepage_resource() override {
+      for (auto& slot : arenas) {
+        delete slot.load(std::memory_order_acquire);
+      }
+    }
+  };
+
+} // namespace coro
+
+#endif //NUMA_FRAME_RESOURCE_H
@@ -0,0 +1,305 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Fused, lazy range adaptors - map, filter, take_while and zip - over
+ * coro::generator (or any other pull source, see below).
+ *
+ * Chaining generators stage by stage costs a coroutine frame and a resume per
+ * stage per element. The adaptors here are instead plain objects that pull from
+ * their source and apply their stage inline, so a pipeline such as:
+ *
+ *   auto rng = parse(file) | coro::views::filter(valid) | coro::views::map(to_record)
+ *                          | coro::views::take_while(in_window);
+ *
+ * allocates the one frame of the source generator and resumes it once per element,
+ * however many stages follow it (and the compiler can inline the stages into the
+ * consumer's loop). Each adaptor is itself a pull source and a std::ranges::view,
+ * so pipelines compose further with these adaptors and with std::views.
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+#include "generator.h"
+
+namespace coro {
+
+  /**
+   * A pull source advances with next(), which returns false once the source is
+   * exhausted, and otherwise exposes its current element via getValueRef() - as
+   * coro::generator<T> does.
+   */
+  template<typename S>
+  concept pull_source = requires(S& s) {
+    { s.next() } -> std::same_as<bool>;
+    s.getValueRef();
+  };
+
+  template<pull_source S>
+  using source_reference_t = decltype(std::declval<S&>().getValueRef());
+
+  namespace detail {
+
+    // refers to a pull source that was passed as an lvalue, i.e., that the pipeline does not own
+    template<pull_source S>
+    class source_ref {
+    private:
+      S* src;
+    public:
+      explicit source_ref(S& s) noexcept : src{std::addressof(s)} {}
+      bool next() { return src->next(); }
+      decltype(auto) getValueRef() { return src->getValueRef(); }
+    };
+
+    template<typename S>
+    using stored_source_t = std::conditional_t<std::is_lvalue_reference_v<S>,
+                                               source_ref<std::remove_reference_t<S>>, std::remove_cvref_t<S>>;
+
+    template<typename S>
+    stored_source_t<S> store_source(S&& s) {
+      if constexpr (std::is_lvalue_reference_v<S>) {
+        return stored_source_t<S>{s};
+      } else {
+        return std::move(s);
+      }
+    }
+
+    /**
+     * Base class of the adaptors that makes each a single-pass std::ranges::view
+     * over the pull source API (next() and getValueRef()) of the Derived class.
+     */
+    template<typename Derived>
+    class pipeline_view : public std::ranges::view_interface<Derived> {
+    public:
+      struct iterator {
+        using difference_type [[maybe_unused]] = std::ptrdiff_t;
+        using value_type [[maybe_unused]] = std::remove_cvref_t<decltype(std::declval<Derived&>().getValueRef())>;
+        Derived* view = nullptr;
+        decltype(auto) operator*() const {
+          assert(view);
+          return view->getValueRef();
+        }
+        iterator& operator++() { // pre-incrementable
+          if (!view->next()) {
+            view = nullptr;
+          }
+          return *this;
+        }
+        void operator ++ (int) { // post-incrementable
+          ++*this;
+        }
+        bool operator==(std::default_sentinel_t) const noexcept {
+          return view == nullptr;
+        }
+      };
+
+      iterator begin() {
+        iterator itr{static_cast<Derived*>(this)};
+        return ++itr;
+      }
+
+      std::default_sentinel_t end() const noexcept {
+        return std::default_sentinel;
+      }
+    };
+
+    // holds the result of a map stage until the source advances, or refers to it if an lvalue
+    template<typename R>
+    class stage_result {
+    private:
+      std::optional<R> value;
+    public:
+      template<typename F, typename... Args>
+      void emplace(F& f, Args&&... args) {
+        value.reset();
+        value.emplace(std::invoke(f, std::forward<Args>(args)...));
+      }
+      R& get() noexcept {
+        assert(value.has_value());
+        return *value;
+      }
+    };
+
+    template<typename R>
+    class stage_result<R&> {
+    private:
+      R* value = nullptr;
+    public:
+      template<typename F, typename... Args>
+      void emplace(F& f, Args&&... args) {
+        value = std::addressof(std::invoke(f, std::forward<Args>(args)...));
+      }
+      R& get() noexcept {
+        assert(value != nullptr);
+        return *value;
+      }
+    };
+
+    /**
+     * Holds the callable of a stage, so that the view is assignable (as a
+     * std::ranges::view must be) even if the callable is not, as a lambda with
+     * captures is not: where F is not assignable, assignment destroys the callable
+     * and copy (or move) constructs the other's in its place.
+     */
+    template<std::copy_constructible F>
+    class movable_box {
+    private:
+      std::optional<F> f;
+    public:
+      explicit movable_box(F fn) : f{std::in_place, std::move(fn)} {}
+      movable_box(const movable_box&) = default;
+      movable_box(movable_box&&) = default;
+      movable_box& operator=(const movable_box& other) {
+        if constexpr (std::copyable<F>) {
+          f = other.f;
+        } else if (this != &other) {
+          f.reset();
+          if (other.f) f.emplace(*other.f);
+        }
+        return *this;
+      }
+      movable_box& operator=(movable_box&& other) noexcept(std::is_nothrow_move_constructible_v<F>) {
+        if constexpr (std::movable<F>) {
+          f = std::move(other.f);
+        } else if (this != &other) {
+          f.reset();
+          if (other.f) f.emplace(std::move(*other.f));
+        }
+        return *this;
+      }
+      F& operator*() noexcept {
+        assert(f.has_value()); // (only empty should the construction of an assigned callable have thrown)
+        return *f;
+      }
+    };
+
+  } // namespace detail
+
+  /**
+   * Applies F to each element of the source; the result is computed once per
+   * element (when the source advances) and lives until the next element.
+   */
+  template<pull_source S, std::copy_constructible F>
+    requires std::invocable<F&, source_reference_t<S>>
+  class map_view : public detail::pipeline_view<map_view<S, F>> {
+  private:
+    using result_type = std::invoke_result_t<F&, source_reference_t<S>>;
+    S src;
+    [[no_unique_address]] detail::movable_box<F> f;
+    detail::stage_result<result_type> current;
+  public:
+    map_view(S s, F fn) : src{std::move(s)}, f{std::move(fn)} {}
+    bool next() {
+      if (!src.next()) return false;
+      current.emplace(*f, src.getValueRef());
+      return true;
+    }
+    std::remove_reference_t<result_type>& getValueRef() noexcept {
+      return current.get();
+    }
+  };
+
+  // skips the elements of the source for which P returns false
+  template<pull_source S, std::copy_constructible P>
+    requires std::predicate<P&, source_reference_t<S>>
+  class filter_view : public detail::pipeline_view<filter_view<S, P>> {
+  private:
+    S src;
+    [[no_unique_address]] detail::movable_box<P> pred;
+  public:
+    filter_view(S s, P p) : src{std::move(s)}, pred{std::move(p)} {}
+    bool next() {
+      while (src.next()) {
+        if (std::invoke(*pred, src.getValueRef())) return true;
+      }
+      return false;
+    }
+    decltype(auto) getValueRef() {
+      return src.getValueRef();
+    }
+  };
+
+  // ends at the first element of the source for which P returns false (the source is not advanced any further)
+  template<pull_source S, std::copy_constructible P>
+    requires std::predicate<P&, source_reference_t<S>>
+  class take_while_view : public detail::pipeline_view<take_while_view<S, P>> {
+  private:
+    S src;
+    [[no_unique_address]] detail::movable_box<P> pred;
+    bool done = false;
+  public:
+    take_while_view(S s, P p) : src{std::move(s)}, pred{std::move(p)} {}
+    bool next() {
+      if (done) return false;
+      done = !(src.next() && std::invoke(*pred, src.getValueRef()));
+      return !done;
+    }
+    decltype(auto) getValueRef() {
+      return src.getValueRef();
+    }
+  };
+
+  /**
+   * Advances all of its sources in lock step, ending with the shortest of them; an
+   * element is a std::tuple of the current elements (references) of the sources.
+   */
+  template<pull_source... S>
+    requires (sizeof...(S) > 0)
+  class zip_view : public detail::pipeline_view<zip_view<S...>> {
+  private:
+    std::tuple<S...> srcs;
+  public:
+    using reference = std::tuple<source_reference_t<S>...>;
+    explicit zip_view(S... s) : srcs{std::move(s)...} {}
+    bool next() {
+      return std::apply([](auto&... s) { return (s.next() && ...); }, srcs);
+    }
+    reference getValueRef() {
+      return std::apply([](auto&... s) { return reference{s.getValueRef()...}; }, srcs);
+    }
+  };
+
+  namespace views {
+
+    namespace detail {
+      // the right-hand side of source | adaptor, i.e., an adaptor that is awaiting its source
+      template<template<typename, typename> typename View, typename F>
+      struct closure {
+        F fn;
+        template<typename S> requires pull_source<std::remove_cvref_t<S>>
+        friend auto operator|(S&& s, closure c) {
+          return View<coro::detail::stored_source_t<S>, F>{coro::detail::store_source(std::forward<S>(s)), std::move(c.fn)};
+        }
+      };
+    } // namespace detail
+
+    template<typename F>
+    auto map(F f) { return detail::closure<map_view, F>{std::move(f)}; }
+
+    template<typename P>
+    auto filter(P p) { return detail::closure<filter_view, P>{std::move(p)}; }
+
+    template<typename P>
+    auto take_while(P p) { return detail::closure<take_while_view, P>{std::move(p)}; }
+
+    // sources passed as lvalues are referenced; rvalues are moved into the view
+    template<typename... S> requires (pull_source<std::remove_cvref_t<S>> && ...)
+    auto zip(S&&... s) {
+      return zip_view<coro::detail::stored_source_t<S>...>{coro::detail::store_source(std::forward<S>(s))...};
+    }
+
+  } // namespace views
+
+} // namespace coro
+
+#endif //PIPELINE_H
@@ -0,0 +1,117 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * The prefetch() adaptor, which runs a generator on a background thread, so that
+ * a CPU-heavy producer (say, decompression) overlaps with its consumer.
+ */
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "channel.h"
+#include "generator.h"
+
+namespace coro {
+
+  namespace detail {
+
+    /**
+     * The background thread, which is stopped (via the stop token bound to the generator
+     * it runs, and via the channel) and joined when the consumer abandons the generator.
+     */
+    class prefetch_worker {
+    private:
+      std::stop_source stop;
+      std::thread thread;
+      void (*cancel)(void*) noexcept;
+      void* channel;
+    public:
+      template<typename T, typename F>
+      prefetch_worker(spsc_channel<T>& ch, std::stop_source s, F&& f)
+        : stop{std::move(s)},
+          thread{std::forward<F>(f)},
+          cancel{[](void* c) noexcept { static_cast<spsc_channel<T>*>(c)->cancel(); }},
+          channel{&ch} {}
+      prefetch_worker(const prefetch_worker&) = delete;
+      prefetch_worker& operator=(const prefetch_worker&) = delete;
+      ~prefetch_worker() {
+        if (thread.joinable()) {
+          stop.request_stop(); // so the generator need not first compute its next value, should it check
+          cancel(channel);
+          thread.join();
+        }
+      }
+      void join() {
+        thread.join();
+      }
+    };
+
+  } // namespace detail
+
+  /**
+   * Runs the generator on a background thread, which fills a bounded SPSC ring
+   * (refer to spsc_channel in channel.h) that the returned generator - iterated on
+   * the consumer's thread like any other - drains. The values are handed to the
+   * consumer by reference to their slot in the ring, i.e., without a further copy.
+   *
+   * The background thread copies each value that the generator yields into the
+   * ring (or moves it, for a move-only value type, as the value of such a
+   * generator can only be consumed by moving from it). An exception escaping the
+   * generator is rethrown to the consumer after the values that preceded it.
+   * Destroying the returned generator stops (and joins) the background thread.
+   *
+   * The token of a std::stop_source of its own is bound to the generator (refer to
+   * set_stop_token()), which is stopped when the returned generator is destroyed, or
+   * once a stop is requested of the token bound to the returned generator.
+   *
+   * @param gen the generator to run on the background thread
+   * @param depth the capacity of the ring (rounded up to a power of two)
+   * @param batch the number of values per hand-over between the threads, i.e., trades
+   *              latency for less cache-line traffic between their cores
+   * @return coroutine task iterator
+   */
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy>
+  generator<std::remove_cv_t<T>> prefetch(generator<T, ExceptionPolicy, AllocationPolicy> gen,
+                                          std::size_t depth = 1024, std::size_t batch = 64) {
+    using value_type = std::remove_cv_t<T>;
+    // not a local of the coroutine, as the frame is not allocated cache-line aligned
+    const auto channel_ptr = std::make_unique<spsc_channel<value_type>>(depth, batch);
+    auto& channel = *channel_ptr;
+    std::stop_source upstream;
+    gen.set_stop_token(upstream.get_token());
+    const auto stop = co_await this_stop_token(); // (a local, as g++ 12 destroys the result twice if passed on directly)
+    const std::stop_callback propagate{stop, [upstream]() mutable noexcept { upstream.request_stop(); }};
+    detail::prefetch_worker worker{channel, upstream, [&channel, &gen] {
+      try {
+        for (auto itr = gen.begin(); itr != gen.end(); ++itr) {
+          bool pushed;
+          if constexpr (std::copy_constructible<value_type>) {
+            pushed = channel.push(std::as_const(*itr));
+          } else {
+            pushed = channel.push(std::move(*itr));
+          }
+          if (!pushed) return; // the consumer abandoned the generator
+        }
+        channel.close();
+      } catch (...) {
+        channel.close(std::current_exception());
+      }
+    }};
+    while (auto value = channel.front()) {
+      co_yield *value;
+      channel.pop();
+    }
+    worker.join();
+    channel.rethrow_if_exception();
+  }
+
+} // namespace coro
+
+#endif //PREFETCH_H
@@ -0,0 +1,429 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * A work-stealing scheduler that resumes coroutines on a pool of worker threads,
+ * e.g., for running tens of thousands of generator-driven tasks concurrently
+ * instead of pumping each with a blocking while (gen.next()) loop.
+ *
+ * Each worker has its own Chase-Lev deque of coroutine handles: a worker pushes
+ * and pops at the bottom of its own deque (LIFO, i.e., cache-warm), while idle
+ * workers steal from the top of the deques of others (FIFO). Coroutines scheduled
+ * from outside of the workers go to a shared injection queue.
+ *
+ * Coroutine frames created on a worker are allocated from that worker's own
+ * frame cache (refer to frame_pool.h), so with the workers pinned to CPUs the
+ * frames stay local to the memory node of the CPU that created them.
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include "async_generator.h"
+#include "channel.h"
+#include "generator.h"
+#include "task.h"
+
+namespace coro {
+
+  namespace detail {
+
+    /**
+     * Chase-Lev work-stealing deque of coroutine handles (per Lê, Pop, Cohen and
+     * Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models").
+     * Only the owner may push() and pop(); any thread may steal(). The ring grows as
+     * needed; the rings it outgrew are retained until the deque is destroyed, as a
+     * concurrent thief may still be reading from one.
+     */
+    class work_stealing_deque {
+    private:
+      struct ring {
+        const std::int64_t capacity;
+        std::unique_ptr<std::atomic<void*>[]> slots;
+        explicit ring(std::int64_t cap) : capacity{cap}, slots{std::make_unique<std::atomic<void*>[]>(cap)} {}
+        void* get(std::int64_t i) const noexcept { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, void* p) noexcept { slots[i & (capacity - 1)].store(p, std::memory_order_relaxed); }
+      };
+
+      alignas(cache_line_size) std::atomic<std::int64_t> top{0};
+      alignas(cache_line_size) std::atomic<std::int64_t> bottom{0};
+      std::atomic<ring*> current;
+      std::vector<std::unique_ptr<ring>> rings; // owner only
+
+      ring* grow(ring* r, std::int64_t b, std::int64_t t) {
+        auto bigger = std::make_unique<ring>(r->capacity * 2);
+        for (auto i = t; i < b; i++) {
+          bigger->put(i, r->get(i));
+        }
+        rings.push_back(std::move(bigger));
+        current.store(rings.back().get(), std::memory_order_release);
+        return rings.back().get();
+      }
+
+    public:
+      explicit work_stealing_deque(std::int64_t initial_capacity = 256) {
+        rings.push_back(std::make_unique<ring>(initial_capacity));
+        current.store(rings.back().get(), std::memory_order_relaxed);
+      }
+      work_stealing_deque(const work_stealing_deque&) = delete;
+      work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+      void push(std::coroutine_handle<> h) {
+        const auto b = bottom.load(std::memory_order_relaxed);
+        const auto t = top.load(std::memory_order_acquire);
+        auto r = current.load(std::memory_order_relaxed);
+        if (b - t > r->capacity - 1) {
+          r = grow(r, b, t);
+        }
+        r->put(b, h.address());
+        bottom.store(b + 1, std::memory_order_release); // publishes the handle (and the frame) to thieves
+      }
+
+      std::coroutine_handle<> pop() noexcept {
+        const auto b = bottom.load(std::memory_order_relaxed) - 1;
+        const auto r = current.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = top.load(std::memory_order_relaxed);
+        void* p = nullptr;
+        if (t <= b) {
+          p = r->get(b);
+          if (t == b) { // the last one - race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+              p = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+          }
+        } else {
+          bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return std::coroutine_handle<>::from_address(p);
+      }
+
+      std::coroutine_handle<> steal() noexcept {
+        auto t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto b = bottom.load(std::memory_order_acquire);
+        if (t < b) {
+          void* p = current.load(std::memory_order_acquire)->get(t);
+          if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return std::coroutine_handle<>::from_address(p);
+          }
+        }
+        return nullptr; // empty, or lost the race to another thief (or the owner)
+      }
+
+      bool empty() const noexcept {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+      }
+    };
+
+  } // namespace detail
+
+  /**
+   * Pool of worker threads that resume coroutines, stealing work from each other
+   * when idle. A coroutine moves onto the scheduler by co_await-ing schedule(), and
+   * tasks are run to completion (detached) via spawn(); wait() blocks until all of
+   * the spawned tasks have completed.
+   */
+  class scheduler {
+  private:
+    struct worker {
+      detail::work_stealing_deque deque;
+      std::thread thread;
+      std::uint32_t rng_state;
+    };
+
+    // the worker (of whichever scheduler) that the calling thread is, if any
+    struct worker_identity {
+      scheduler* sched = nullptr;
+      worker* self = nullptr;
+    };
+    static worker_identity& this_worker() noexcept {
+      static thread_local worker_identity identity;
+      return identity;
+    }
+
+    std::vector<std::unique_ptr<worker>> workers;
+    std::mutex injection_mtx;
+    std::deque<std::coroutine_handle<>> injection_queue;
+    std::atomic<std::size_t> injected{0};
+
+    alignas(cache_line_size) std::atomic<std::uint32_t> wake_epoch{0};
+    std::atomic<std::uint32_t> sleepers{0};
+    std::atomic<bool> stopping{false};
+
+    alignas(cache_line_size) std::atomic<std::size_t> outstanding{0}; // spawned tasks not completed yet
+    std::mutex exception_mtx;
+    std::exception_ptr first_exception{};
+    std::stop_source stop_source; // of the tasks of for_each() (see below)
+
+    struct spawned_task {
+      struct promise_type : pmr_promise_allocation {
+        scheduler* sched = nullptr;
+        spawned_task get_return_object() noexcept {
+          return spawned_task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; } // the frame destroys itself
+        void return_void() noexcept {}
+        [[noreturn]] void unhandled_exception() noexcept { std::terminate(); } // the body catches everything
+      };
+      std::coroutine_handle<promise_type> hdl;
+    };
+
+    template<typename Task>
+    static spawned_task run_detached(scheduler& s, Task t) {
+      try {
+        co_await std::move(t);
+      } catch (...) {
+        s.record_exception(std::current_exception());
+      }
+      s.task_done();
+    }
+
+    void record_exception(std::exception_ptr ex) noexcept {
+      std::lock_guard<std::mutex> lk{exception_mtx};
+      if (!first_exception) first_exception = std::move(ex);
+    }
+
+    void task_done() noexcept {
+      if (outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        outstanding.notify_all();
+      }
+    }
+
+    void wake_one() noexcept {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (sleepers.load(std::memory_order_relaxed) > 0) {
+        wake_epoch.fetch_add(1, std::memory_order_release);
+        wake_epoch.notify_one();
+      }
+    }
+
+    std::coroutine_handle<> pop_injected() {
+      if (injected.load(std::memory_order_relaxed) == 0) return nullptr;
+      std::lock_guard<std::mutex> lk{injection_mtx};
+      if (injection_queue.empty()) return nullptr;
+      const auto h = injection_queue.front();
+      injection_queue.pop_front();
+      injected.fetch_sub(1, std::memory_order_relaxed);
+      return h;
+    }
+
+    std::coroutine_handle<> steal_from_others(worker& self) noexcept {
+      const auto n = workers.size();
+      // xorshift - a random first victim, so thieves do not all converge on the same deque
+      self.rng_state ^= self.rng_state << 13;
+      self.rng_state ^= self.rng_state >> 17;
+      self.rng_state ^= self.rng_state << 5;
+      const auto first = self.rng_state % n;
+      for (std::size_t i = 0; i < n; i++) {
+        auto& victim = *workers[(first + i) % n];
+        if (&victim == &self) continue;
+        if (auto h = victim.deque.steal()) return h;
+      }
+      return nullptr;
+    }
+
+    bool has_work() const noexcept {
+      if (injected.load(std::memory_order_relaxed) > 0) return true;
+      return std::any_of(workers.begin(), workers.end(), [](const auto& w) { return !w->deque.empty(); });
+    }
+
+    void run(worker& self, std::size_t index, bool pin) {
+      if (pin) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+        ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus); // best effort
+      }
+      this_worker() = worker_identity{this, &self};
+      while (!stopping.load(std::memory_order_acquire)) {
+        auto h = self.deque.pop();
+        if (!h) h = pop_injected();
+        if (!h) h = steal_from_others(self);
+        if (h) {
+          h.resume();
+          continue;
+        }
+        // idle - spin (and yield) for a while, then sleep until more work is scheduled
+        bool found = false;
+        for (detail::backoff b; !found && b.pause(); ) {
+          found = has_work();
+        }
+        if (found) continue;
+        const auto epoch = wake_epoch.load(std::memory_order_acquire);
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!has_work() && !stopping.load(std::memory_order_acquire)) {
+          wake_epoch.wait(epoch, std::memory_order_acquire);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+      }
+      this_worker() = worker_identity{};
+    }
+
+  public:
+    /**
+     * @param num_workers the number of worker threads
+     * @param pin_workers pins worker i to CPU i (modulo the number of CPUs), so that
+     *                    the frames a worker allocates stay on its memory node
+     */
+    explicit scheduler(std::size_t num_workers = std::max(1u, std::thread::hardware_concurrency()),
+                       bool pin_workers = false) {
+      workers.reserve(std::max<std::size_t>(num_workers, 1));
+      for (std::size_t i = 0; i < std::max<std::size_t>(num_workers, 1); i++) {
+        workers.push_back(std::make_unique<worker>());
+        workers.back()->rng_state = static_cast<std::uint32_t>(i * 2654435761u + 1);
+      }
+      for (std::size_t i = 0; i < workers.size(); i++) {
+        workers[i]->thread = std::thread{&scheduler::run, this, std::ref(*workers[i]), i, pin_workers};
+      }
+    }
+    scheduler(const scheduler&) = delete;
+    scheduler& operator=(const scheduler&) = delete;
+    // waits for the spawned tasks to complete before stopping the workers
+    ~scheduler() {
+      outstanding_wait();
+      stopping.store(true, std::memory_order_release);
+      wake_epoch.fetch_add(1, std::memory_order_release);
+      wake_epoch.notify_all();
+      for (auto& w : workers) w->thread.join();
+    }
+
+    std::size_t size() const noexcept { return workers.size(); }
+
+    /**
+     * The token of the scheduler, which the tasks of for_each() observe unless given one
+     * of their own: request_stop() has them stop draining their generators (and stops
+     * the token bound to those generators), so that wait() returns early.
+     */
+    std::stop_token get_stop_token() const noexcept { return stop_source.get_token(); }
+    bool request_stop() noexcept { return stop_source.request_stop(); }
+
+    /**
+     * Schedules the coroutine to be resumed on one of the workers: onto the calling
+     * worker's own deque (whence other workers may steal it), or else, when called
+     * from outside of the workers, onto the injection queue.
+     */
+    void enqueue(std::coroutine_handle<> h) {
+      auto& identity = this_worker();
+      if (identity.sched == this) {
+        identity.self->deque.push(h);
+      } else {
+        std::lock_guard<std::mutex> lk{injection_mtx};
+        injection_queue.push_back(h);
+        injected.fetch_add(1, std::memory_order_relaxed);
+      }
+      wake_one();
+    }
+
+    // co_await schedule() moves the awaiting coroutine onto (another) one of the workers
+    auto schedule() noexcept {
+      struct schedule_awaiter {
+        scheduler& sched;
+        constexpr bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { sched.enqueue(h); }
+        constexpr void await_resume() const noexcept {}
+      };
+      return schedule_awaiter{*this};
+    }
+
+    /**
+     * Runs the task to completion on the workers, without the caller awaiting it. An
+     * exception escaping any of the spawned tasks is rethrown by wait() (the first one).
+     */
+    template<typename T, typename ExceptionPolicy, typename AllocationPolicy>
+    void spawn(task<T, ExceptionPolicy, AllocationPolicy> t) {
+      outstanding.fetch_add(1, std::memory_order_relaxed);
+      auto detached = run_detached(*this, std::move(t));
+      enqueue(detached.hdl);
+    }
+
+    // blocks until all of the spawned tasks have completed (must not be called by a worker)
+    void wait() {
+      assert(this_worker().sched != this);
+      outstanding_wait();
+      std::lock_guard<std::mutex> lk{exception_mtx};
+      if (first_exception) {
+        std::rethrow_exception(std::exchange(first_exception, nullptr));
+      }
+    }
+
+  private:
+    void outstanding_wait() noexcept {
+      for (auto n = outstanding.load(std::memory_order_acquire); n != 0; n = outstanding.load(std::memory_order_acquire)) {
+        outstanding.wait(n, std::memory_order_acquire);
+      }
+    }
+  };
+
+  /**
+   * A task that drains the generator on the scheduler, invoking f on each value,
+   * and that moves to the back of the scheduler's queues after every quantum values,
+   * so that long running generators do not monopolise a worker:
+   *
+   *   sched.spawn(coro::for_each(sched, fibonacci(ceiling), [](auto& value) { ... }));
+   *
+   * The task stops early, without resuming the generator again, once a stop is
+   * requested of the token - e.g., one per client, stopped once it disconnects -
+   * which is also bound to the generator (refer to set_stop_token()). The quantum
+   * must be at least 1.
+   */
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy, typename F>
+  task<> for_each(scheduler& sched, generator<T, ExceptionPolicy, AllocationPolicy> gen, F f,
+                  std::stop_token stop, std::size_t quantum = 256) {
+    assert(quantum > 0);
+    gen.set_stop_token(stop);
+    co_await sched.schedule();
+    for (std::size_t n = 1; !stop.stop_requested() && gen.next(); n++) {
+      std::invoke(f, gen.getValueRef());
+      if (n % quantum == 0) co_await sched.schedule();
+    }
+  }
+
+  // likewise, observing the token of the scheduler (refer to scheduler::request_stop())
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy, typename F>
+  task<> for_each(scheduler& sched, generator<T, ExceptionPolicy, AllocationPolicy> gen, F f,
+                  std::size_t quantum = 256) {
+    return for_each(sched, std::move(gen), std::move(f), sched.get_stop_token(), quantum);
+  }
+
+  // likewise for an asynchronous generator, whose body may suspend on its own, too
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy, typename F>
+  task<> for_each(scheduler& sched, async_generator<T, ExceptionPolicy, AllocationPolicy> gen, F f,
+                  std::stop_token stop, std::size_t quantum = 256) {
+    assert(quantum > 0);
+    gen.set_stop_token(stop);
+    co_await sched.schedule();
+    for (std::size_t n = 1; !stop.stop_requested() && co_await gen.next(); n++) {
+      std::invoke(f, gen.getValueRef());
+      if (n % quantum == 0) co_await sched.schedule();
+    }
+  }
+
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy, typename F>
+  task<> for_each(scheduler& sched, async_generator<T, ExceptionPolicy, AllocationPolicy> gen, F f,
+                  std::size_t quantum = 256) {
+    return for_each(sched, std::move(gen), std::move(f), sched.get_stop_token(), quantum);
+  }
+
+} // namespace coro
+
+#endif //SCHEDULER_H
@@ -0,0 +1,271 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * The ascending_sequence() and fibonacci() generator functions (formerly
+ * defined in main.cpp), shared by the demo program and the benchmarks, their
+ * checkpointable counterparts, splittable_ascending_sequence() - which can be
+ * generated in parallel - and fibonacci_sequence() - of which a table can be
+ * evaluated at compile time.
+ */
+#ifndef SEQUENCES_H
+#define SEQUENCES_H
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include "generator.h"
+#include "checkpointable_generator.h"
+#include "constexpr_sequence.h"
+#include "splittable_generator.h"
+
+// concept to constrain function templates that follow to only accept arithmetic types
+template <typename T>
+concept arithmetic = std::integral<T> || std::floating_point<T>;
+
+/**
+ * Returns number in ascending sequence starting at specified value.
+ *
+ * @tparam T arithmetic type of number returned
+ * @tparam Generator generator type returned, e.g., coro::generator<T, coro::terminate_on_exception>
+ * @param mr pmr memory_resource that the coroutine frame is allocated from
+ * @param start value to begin sequence at
+ * @return coroutine task iterator
+ */
+template<arithmetic T, typename Generator = coro::generator<T>>
+Generator ascending_sequence(std::allocator_arg_t, std::pmr::memory_resource* mr, const T start) {
+  T i = start;
+  // generate_into() fills whole SIMD registers at a time, and skip() jumps ahead, instead of resuming per value
+  coro::sequence_hooks hooks{
+    [&i](std::span<T> out) noexcept { return coro::iota_fill(out, i); },
+    [&i](std::size_t n) noexcept {
+      if constexpr (std::integral<T>) {
+        i += static_cast<T>(n);
+      } else { // accumulated one after another, so the values are the same as those of the loop below
+        for (std::size_t k = 0; k < n; k++) i++;
+      }
+      return n;
+    }
+  };
+  co_yield hooks;
+  while (true) {
+    T j = i++;
+    co_yield j;
+  }
+}
+
+template<arithmetic T, typename Generator = coro::generator<T>>
+Generator ascending_sequence(const T start) {
+  return ascending_sequence<T, Generator>(std::allocator_arg, coro::pmem_pool, start);
+}
+
+namespace coro {
+
+  namespace detail {
+
+    // x * y + z * w, of operands that are not negative, unless it exceeds ceiling
+    template<std::integral T>
+    bool fibonacci_fma_at_most(T x, T y, T z, T w, T ceiling, T& result) noexcept {
+      if (y != 0 && x > ceiling / y) return false;
+      const T xy = x * y;
+      if (w != 0 && z > (ceiling - xy) / w) return false;
+      result = xy + z * w;
+      return true;
+    }
+
+    /**
+     * Advances the Fibonacci state (j, i) = (F(k-1), F(k)) by n numbers, to (F(k+n-1), F(k+n)),
+     * at a cost of O(log n), via the fast doubling identities F(2t) = F(t)(2F(t+1) - F(t)) and
+     * F(2t+1) = F(t)^2 + F(t+1)^2. Leaves the state as is, and returns false, should F(k+n)
+     * exceed ceiling (so none of the intermediate results can overflow T either).
+     */
+    template<std::integral T>
+    bool fibonacci_jump(T& j, T& i, std::size_t n, T ceiling) noexcept {
+      T a = 0; // F(t)
+      T b = 1; // F(t+1)
+      for (int bit = std::bit_width(n) - 1; bit >= 0; bit--) {
+        if (b - a > ceiling - b) return false;
+        T c, d; // F(2t), F(2t+1)
+        if (!fibonacci_fma_at_most(a, T(b + (b - a)), T(0), T(0), ceiling, c)) return false;
+        if (!fibonacci_fma_at_most(a, a, b, b, ceiling, d)) return false;
+        if ((n >> bit) & 1) {
+          if (c > ceiling - d) return false;
+          a = d;
+          b = c + d;
+        } else {
+          a = c;
+          b = d;
+        }
+      }
+      // F(k+n) = F(k)F(n+1) + F(k-1)F(n), and F(k+n-1) = F(k)F(n) + F(k-1)F(n-1)
+      T next_i, next_j;
+      if (!fibonacci_fma_at_most(i, b, j, a, ceiling, next_i)) return false;
+      if (!fibonacci_fma_at_most(i, a, j, T(b - a), ceiling, next_j)) return false;
+      i = next_i;
+      j = next_j;
+      return true;
+    }
+
+  } // namespace detail
+
+} // namespace coro
+
+/**
+ * Generates Fibonacci sequence up to specified ceiling value.
+ *
+ * @tparam T arithmetic type of number returned
+ * @tparam Generator generator type returned, e.g., coro::elidable_generator<T> (whose
+ *                   coroutine frame is not allocated from mr but may be elided instead)
+ * @param mr pmr memory_resource that the coroutine frame is allocated from
+ * @param ceiling terminates generation of sequence when reaching
+ * @return coroutine task iterator
+ */
+template<arithmetic T, typename Generator = coro::generator<T>>
+Generator fibonacci(std::allocator_arg_t, std::pmr::memory_resource* mr, const T ceiling) {
+  T j = 0;
+  T i = 1;
+  co_yield j;
+  if (ceiling > j) {
+    // skip() jumps ahead in O(log n), while the values to skip do not exceed ceiling - but not for
+    // floating point values, which the jump would not compute the same as the loop below does
+    coro::sequence_hooks hooks{coro::no_hook{}, [&j, &i, ceiling] {
+      if constexpr (std::integral<T>) {
+        return [&j, &i, ceiling](std::size_t n) noexcept { return coro::detail::fibonacci_jump(j, i, n, ceiling) ? n : 0; };
+      } else {
+        return coro::no_hook{};
+      }
+    }()};
+    co_yield hooks;
+    do {
+      co_yield i;
+      T tmp = i;
+      i += j;
+      j = tmp;
+    } while (i <= ceiling);
+  }
+}
+
+template<arithmetic T, typename Generator = coro::generator<T>>
+Generator fibonacci(const T ceiling) {
+  return fibonacci<T, Generator>(std::allocator_arg, coro::pmem_pool, ceiling);
+}
+
+/**
+ * Returns the same numbers as ascending_sequence() does, as a splittable_generator
+ * (refer to splittable_generator.h), so that index ranges of the sequence can be
+ * generated concurrently - each value computed from its index, i.e., start + index,
+ * which for a floating point T is the same value as the accumulated one for as long
+ * as the values are integers (of start) that T represents exactly.
+ *
+ * @tparam T arithmetic type of number returned
+ * @param start value to begin sequence at, i.e., the value at index 0
+ * @return the sequence, of which split(first, last) returns a generator
+ */
+template<arithmetic T>
+auto splittable_ascending_sequence(const T start) {
+  return coro::indexed_sequence{[start](std::size_t index) { return static_cast<T>(start + static_cast<T>(index)); }};
+}
+
+// loop state of fibonacci_sequence(), i.e., the next two numbers of the sequence and its ceiling
+template<arithmetic T>
+struct fibonacci_table_state {
+  T j = 0;
+  T i = 1;
+  T ceiling;
+};
+
+/**
+ * The Fibonacci sequence up to specified ceiling value - the same sequence as
+ * fibonacci() generates (for a ceiling of at least 0) - as a constexpr_sequence,
+ * which is a generator at runtime and, for a constant ceiling, a table evaluated
+ * at compile time (refer to constexpr_sequence.h):
+ * ```
+ *     constexpr auto& table = coro::sequence_table<fibonacci_sequence(1'000ul)>;
+ * ```
+ *
+ * @tparam T arithmetic type of number returned
+ * @param ceiling terminates generation of sequence when reaching
+ * @return step function and initial state of the sequence
+ */
+template<arithmetic T>
+constexpr auto fibonacci_sequence(const T ceiling) {
+  return coro::constexpr_sequence{fibonacci_table_state<T>{0, 1, ceiling}, [](fibonacci_table_state<T>& s) -> std::optional<T> {
+    if (!(s.j <= s.ceiling)) return std::nullopt;
+    T value = s.j;
+    T tmp = s.i;
+    s.i += s.j;
+    s.j = tmp;
+    return value;
+  }};
+}
+
+// loop state of checkpointable_ascending_sequence(), i.e., the number to return next
+template<arithmetic T>
+struct ascending_sequence_state {
+  T next;
+};
+
+/**
+ * Returns number in ascending sequence starting at specified value, as
+ * ascending_sequence() does, but can be snapshotted and restored mid-sequence
+ * (refer to checkpointable_generator.h).
+ *
+ * @tparam T arithmetic type of number returned
+ * @param mr pmr memory_resource that the coroutine frame is allocated from
+ * @param start value to begin sequence at (unless restored from a snapshot)
+ * @return coroutine task iterator
+ */
+template<arithmetic T>
+coro::checkpointable_generator<T, ascending_sequence_state<T>>
+checkpointable_ascending_sequence(std::allocator_arg_t, std::pmr::memory_resource* mr, const T start) {
+  auto& s = co_await coro::checkpoint_state{ascending_sequence_state<T>{start}};
+  while (true) {
+    T j = s.next++;
+    co_yield j;
+  }
+}
+
+template<arithmetic T>
+coro::checkpointable_generator<T, ascending_sequence_state<T>> checkpointable_ascending_sequence(const T start) {
+  return checkpointable_ascending_sequence(std::allocator_arg, coro::pmem_pool, start);
+}
+
+// loop state of checkpointable_fibonacci(), i.e., the next two numbers of the sequence
+template<arithmetic T>
+struct fibonacci_state {
+  T j = 0;
+  T i = 1;
+};
+
+/**
+ * Generates Fibonacci sequence up to specified ceiling value - the same sequence as
+ * fibonacci() does (for a ceiling of at least 1) - but can be snapshotted and
+ * restored mid-sequence (refer to checkpointable_generator.h).
+ *
+ * @tparam T arithmetic type of number returned
+ * @param mr pmr memory_resource that the coroutine frame is allocated from
+ * @param ceiling terminates generation of sequence when reaching
+ * @return coroutine task iterator
+ */
+template<arithmetic T>
+coro::checkpointable_generator<T, fibonacci_state<T>>
+checkpointable_fibonacci(std::allocator_arg_t, std::pmr::memory_resource* mr, const T ceiling) {
+  auto& s = co_await coro::checkpoint_state{fibonacci_state<T>{}};
+  while (s.j <= ceiling) {
+    T value = s.j;
+    T tmp = s.i;
+    s.i += s.j;
+    s.j = tmp;
+    co_yield value;
+  }
+}
+
+template<arithmetic T>
+coro::checkpointable_generator<T, fibonacci_state<T>> checkpointable_fibonacci(const T ceiling) {
+  return checkpointable_fibonacci(std::allocator_arg, coro::pmem_pool, ceiling);
+}
+
+#endif //SEQUENCES_H
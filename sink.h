@@ -0,0 +1,313 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Sinks that drain a generator (or a batch_generator) directly into their
+ * destination, rather than streaming each value through an iostream:
+ *
+ * to_vector()     - appends the values to a std::vector, with a capacity hint
+ * to_pmr_vector() - likewise, to a std::pmr::vector allocated from a memory_resource
+ * to_file()       - formats the values (via std::to_chars) into a buffer that is
+ *                   written to a file (or file descriptor) whenever it fills up
+ * to_socket()     - likewise, to a connected stream socket, without raising SIGPIPE
+ *
+ * The text sinks make one write syscall per buffer (64 KiB by default); a string
+ * value too large to be worth copying into the buffer is instead gathered, along
+ * with the buffer, by the same writev() (or sendmsg()) call. Numbers are formatted
+ * independent of the locale: integers in decimal, floating point values in their
+ * shortest form that reads back as the same value.
+ */
+#ifndef SINK_H
+#define SINK_H
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <assert.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "batch_generator.h"
+#include "file_records.h"
+#include "generator.h"
+
+namespace coro {
+
+  // values that the text sinks can write: numbers (but not bool), single characters, and strings
+  template<typename T>
+  concept sink_formattable = (std::is_arithmetic_v<T> && !std::same_as<T, bool>)
+      || std::convertible_to<const T&, std::string_view>;
+
+  namespace detail {
+
+    // the values of generate_into() per call, when draining a generator of numbers into a sink
+    inline constexpr std::size_t sink_chunk_size = 256;
+
+    /**
+     * Appends the values of the generator to the vector. Values that can be written
+     * in place are written by generate_into() into the unused capacity of the vector
+     * (or into as many values again as it holds, when it is full), so that a fill
+     * hook of the generator (refer to sequence_hooks) writes them directly.
+     */
+    template<typename Vector, typename T, typename ExceptionPolicy, typename AllocationPolicy>
+    void append_values(Vector& values, const generator<T, ExceptionPolicy, AllocationPolicy>& gen) {
+      using value_type = typename generator<T, ExceptionPolicy, AllocationPolicy>::value_type;
+      if constexpr (std::default_initializable<value_type> && std::movable<value_type>) {
+        for (;;) {
+          const auto size = values.size();
+          const auto spare = values.capacity() - size;
+          const auto chunk = spare > 0 ? spare : std::max(size, sink_chunk_size);
+          values.resize(size + chunk);
+          const auto n = gen.generate_into(std::span<value_type>{values.data() + size, chunk});
+          if (n < chunk) {
+            values.resize(size + n);
+            return;
+          }
+        }
+      } else {
+        while (gen.next()) {
+          if constexpr (std::copy_constructible<value_type>) {
+            values.push_back(std::as_const(gen.getValueRef()));
+          } else {
+            values.push_back(std::move(gen.getValueRef()));
+          }
+        }
+      }
+    }
+
+    template<typename Vector, typename T, std::size_t N, typename ExceptionPolicy, typename AllocationPolicy>
+    void append_values(Vector& values, const batch_generator<T, N, ExceptionPolicy, AllocationPolicy>& gen) {
+      while (gen.next()) {
+        const auto batch = gen.getBatch();
+        values.insert(values.end(), batch.begin(), batch.end());
+      }
+    }
+
+    enum class sink_target { file, socket };
+
+    /**
+     * Formats values, each followed by the separator, into a buffer that it writes to
+     * the file descriptor whenever the next value does not fit (and when flushed). A
+     * write that is interrupted, or that the descriptor accepts only in part, is
+     * resumed; a non-blocking descriptor is polled until it is writable.
+     */
+    class text_sink_writer {
+    private:
+      static constexpr std::size_t max_number_size = 64; // of any number formatted by std::to_chars (shortest form)
+
+      const int fd;
+      const sink_target target;
+      const std::string_view separator;
+      const std::size_t capacity;
+      const std::unique_ptr<char[]> buffer;
+      std::size_t size = 0;
+      std::size_t bytes_written = 0;
+
+      void write_all(iovec* iov, int iov_count) {
+        while (iov_count > 0) {
+          ssize_t n;
+          if (target == sink_target::socket) {
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = static_cast<std::size_t>(iov_count);
+            n = ::sendmsg(fd, &msg, MSG_NOSIGNAL); // a closed peer is reported as EPIPE rather than by a signal
+          } else {
+            n = ::writev(fd, iov, iov_count);
+          }
+          if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+              pollfd writable{fd, POLLOUT, 0};
+              ::poll(&writable, 1, -1);
+              continue;
+            }
+            throw std::system_error(errno, std::generic_category(), target == sink_target::socket ? "sendmsg" : "writev");
+          }
+          bytes_written += static_cast<std::size_t>(n);
+          auto remaining = static_cast<std::size_t>(n);
+          for (; iov_count > 0 && remaining >= iov->iov_len; iov++, iov_count--) {
+            remaining -= iov->iov_len;
+          }
+          if (iov_count > 0) { // written in part
+            iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+          }
+        }
+      }
+
+      void append(const char* chars, std::size_t count) noexcept {
+        std::memcpy(buffer.get() + size, chars, count);
+        size += count;
+      }
+    public:
+      text_sink_writer(int file_descriptor, sink_target t, std::string_view sep, std::size_t buffer_size)
+        : fd{file_descriptor}, target{t}, separator{sep},
+          capacity{std::max(buffer_size, 4 * (max_number_size + sep.size()))},
+          buffer{std::make_unique_for_overwrite<char[]>(capacity)} {}
+      text_sink_writer(const text_sink_writer&) = delete;
+      text_sink_writer& operator=(const text_sink_writer&) = delete;
+
+      std::size_t written() const noexcept { return bytes_written; }
+
+      void flush() {
+        if (size > 0) {
+          iovec iov{buffer.get(), size};
+          size = 0;
+          write_all(&iov, 1);
+        }
+      }
+
+      template<sink_formattable V>
+      void put(const V& value) {
+        if constexpr (std::convertible_to<const V&, std::string_view>) {
+          const std::string_view chars = value;
+          if (chars.size() + separator.size() > capacity - size) {
+            if (chars.size() >= capacity / 4) { // gathered, rather than copied
+              iovec iov[]{{buffer.get(), size},
+                          {const_cast<char*>(chars.data()), chars.size()},
+                          {const_cast<char*>(separator.data()), separator.size()}};
+              size = 0;
+              write_all(iov, 3);
+              return;
+            }
+            flush();
+          }
+          append(chars.data(), chars.size());
+        } else {
+          if (max_number_size + separator.size() > capacity - size) {
+            flush();
+          }
+          if constexpr (std::same_as<V, char>) {
+            buffer[size++] = value;
+          } else {
+            const auto result = std::to_chars(buffer.get() + size, buffer.get() + capacity, value);
+            assert(result.ec == std::errc{});
+            size = static_cast<std::size_t>(result.ptr - buffer.get());
+          }
+        }
+        append(separator.data(), separator.size());
+      }
+
+      template<typename T, typename ExceptionPolicy, typename AllocationPolicy>
+      void put_all(const generator<T, ExceptionPolicy, AllocationPolicy>& gen) {
+        using value_type = typename generator<T, ExceptionPolicy, AllocationPolicy>::value_type;
+        if constexpr (std::is_arithmetic_v<value_type>) { // in chunks, written by a fill hook where there is one
+          std::array<value_type, sink_chunk_size> chunk;
+          std::size_t n;
+          do {
+            n = gen.generate_into(chunk);
+            for (std::size_t k = 0; k < n; k++) put(chunk[k]);
+          } while (n == chunk.size());
+        } else { // by reference, as a string value (say, a std::string_view) may not outlive the next resume
+          while (gen.next()) put(gen.getValueRef());
+        }
+      }
+
+      template<typename T, std::size_t N, typename ExceptionPolicy, typename AllocationPolicy>
+      void put_all(const batch_generator<T, N, ExceptionPolicy, AllocationPolicy>& gen) {
+        while (gen.next()) {
+          for (const auto& value : gen.getBatch()) put(value);
+        }
+      }
+    };
+
+    template<typename G>
+    std::size_t write_text(const G& gen, int fd, sink_target target, std::string_view separator, std::size_t buffer_size) {
+      text_sink_writer writer{fd, target, separator, buffer_size};
+      writer.put_all(gen);
+      writer.flush();
+      return writer.written();
+    }
+
+    template<typename G>
+    concept sink_generator = requires { typename G::value_type; } && sink_formattable<typename G::value_type>;
+
+  } // namespace detail
+
+  /**
+   * Drains the generator (or batch_generator) into a std::vector.
+   *
+   * @param gen the generator to drain
+   * @param capacity_hint the number of values to reserve room for up front, e.g., the expected number of values
+   * @return the values of the generator
+   */
+  template<typename G>
+  auto to_vector(const G& gen, std::size_t capacity_hint = 0) {
+    std::vector<typename G::value_type> values;
+    values.reserve(capacity_hint);
+    detail::append_values(values, gen);
+    return values;
+  }
+
+  /**
+   * Drains the generator (or batch_generator) into a std::pmr::vector, allocated from mr.
+   *
+   * @param gen the generator to drain
+   * @param mr the memory_resource of the vector
+   * @param capacity_hint the number of values to reserve room for up front, e.g., the expected number of values
+   * @return the values of the generator
+   */
+  template<typename G>
+  auto to_pmr_vector(const G& gen, std::pmr::memory_resource* mr = std::pmr::get_default_resource(),
+                     std::size_t capacity_hint = 0) {
+    std::pmr::vector<typename G::value_type> values{mr};
+    values.reserve(capacity_hint);
+    detail::append_values(values, gen);
+    return values;
+  }
+
+  /**
+   * Drains the generator (or batch_generator) into the file descriptor, as text: each
+   * value followed by the separator, written once buffer_size bytes have accumulated
+   * (and at the end). The descriptor is neither closed nor synced.
+   *
+   * @param gen the generator to drain
+   * @param fd the file descriptor to write to, e.g., STDOUT_FILENO
+   * @param separator written after each value
+   * @param buffer_size the bytes written per write syscall (at most, bar large strings)
+   * @return the number of bytes written
+   */
+  template<detail::sink_generator G>
+  std::size_t to_file(const G& gen, int fd, std::string_view separator = "\n", std::size_t buffer_size = 64 * 1024) {
+    return detail::write_text(gen, fd, detail::sink_target::file, separator, buffer_size);
+  }
+
+  /**
+   * As above, but to the file at the path, which is created (or truncated) first.
+   */
+  template<detail::sink_generator G>
+  std::size_t to_file(const G& gen, const std::filesystem::path& path, std::string_view separator = "\n",
+                      std::size_t buffer_size = 64 * 1024) {
+    const detail::file_descriptor fd{path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644};
+    return detail::write_text(gen, fd.get(), detail::sink_target::file, separator, buffer_size);
+  }
+
+  /**
+   * As to_file(), but to a connected stream socket, via sendmsg() with MSG_NOSIGNAL:
+   * should the peer have closed the connection, a std::system_error (EPIPE) is thrown
+   * rather than SIGPIPE raised. A non-blocking socket is polled whilst it is full.
+   * The socket is not closed.
+   */
+  template<detail::sink_generator G>
+  std::size_t to_socket(const G& gen, int socket_fd, std::string_view separator = "\n",
+                        std::size_t buffer_size = 64 * 1024) {
+    return detail::write_text(gen, socket_fd, detail::sink_target::socket, separator, buffer_size);
+  }
+
+} // namespace coro
+
+#endif //SINK_H
@@ -0,0 +1,302 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * Sequences whose values can be generated by index range - each range by a
+ * generator of its own - so that a CPU-bound sequence can be generated on all the
+ * workers of a scheduler instead of on one thread, with its values in the same
+ * (index) order as the sequential generator would yield them:
+ *
+ * parallel_generate_into() - writes the values of an index range into a span
+ * parallel_for_each()      - invokes a function on each value of an index range
+ * parallel_sequence()      - a generator of the values of an index range, whose
+ *                            pieces are generated ahead of the consumer
+ */
+#ifndef SPLITTABLE_GENERATOR_H
+#define SPLITTABLE_GENERATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <assert.h>
+#include "generator.h"
+#include "scheduler.h"
+#include "sink.h"
+#include "task.h"
+
+namespace coro {
+
+  namespace detail {
+
+    template<typename G>
+    struct is_generator : std::false_type {};
+    template<typename T, typename ExceptionPolicy, typename AllocationPolicy>
+    struct is_generator<generator<T, ExceptionPolicy, AllocationPolicy>> : std::true_type {};
+
+  } // namespace detail
+
+  /**
+   * A sequence that can be split by index: seq.split(first, last) returns a generator
+   * of the values at the indices [first, last) of the sequence - the same values, and
+   * as many, as the whole sequence has at those indices - independently of any other
+   * generator of the sequence, so the pieces of an index range can be generated
+   * concurrently and concatenated in order.
+   */
+  template<typename S>
+  concept splittable_generator = std::copy_constructible<S>
+      && requires(const S& seq, std::size_t first, std::size_t last) { seq.split(first, last); }
+      && detail::is_generator<decltype(std::declval<const S&>().split(std::size_t{}, std::size_t{}))>::value;
+
+  template<splittable_generator S>
+  using split_value_t = typename decltype(std::declval<const S&>().split(std::size_t{}, std::size_t{}))::value_type;
+
+  namespace detail {
+
+    /**
+     * The values of at(first) ... at(last - 1), where a fill hook writes them (or a skip
+     * hook passes them) without resuming the coroutine per value.
+     */
+    template<typename F, typename V = std::remove_cvref_t<std::invoke_result_t<const F&, std::size_t>>>
+    generator<V> indexed_range(F at, const std::size_t first, const std::size_t last) {
+      std::size_t i = first;
+      coro::sequence_hooks hooks{
+        [&i, &at, last](std::span<V> out) {
+          const auto n = std::min(out.size(), last - i);
+          for (std::size_t k = 0; k < n; k++) {
+            out[k] = std::invoke(at, i + k);
+          }
+          i += n;
+          return n;
+        },
+        [&i, last](std::size_t n) noexcept {
+          n = std::min(n, last - i);
+          i += n;
+          return n;
+        }
+      };
+      co_yield hooks;
+      while (i < last) {
+        V value = std::invoke(at, i++);
+        co_yield value;
+      }
+    }
+
+    // the pieces of an index range that are generated by tasks on a scheduler, which the caller waits for
+    class split_join {
+    private:
+      std::latch pending;
+      std::mutex mtx;
+      std::exception_ptr first_exception;
+    public:
+      explicit split_join(std::size_t num_pieces) : pending{static_cast<std::ptrdiff_t>(num_pieces)} {}
+
+      template<typename F>
+      task<> run(F body) {
+        try {
+          body();
+        } catch (...) {
+          std::lock_guard<std::mutex> lk{mtx};
+          if (!first_exception) first_exception = std::current_exception();
+        }
+        pending.count_down();
+        co_return;
+      }
+
+      // blocks until the pieces have all completed, and rethrows the first exception to have escaped any of them
+      void wait() {
+        pending.wait();
+        std::lock_guard<std::mutex> lk{mtx};
+        if (first_exception) std::rethrow_exception(first_exception);
+      }
+    };
+
+    /**
+     * Splits [first, last) into pieces of grain indices (the last piece may be smaller),
+     * and spawns a task per piece that invokes f(begin, end) - f must outlive join.wait().
+     */
+    template<typename F>
+    void spawn_pieces(scheduler& sched, split_join& join, std::size_t first, std::size_t last, std::size_t grain,
+                      const F& f) {
+      for (std::size_t begin = first; begin < last; begin += std::min(grain, last - begin)) {
+        const auto end = begin + std::min(grain, last - begin);
+        sched.spawn(join.run([&f, begin, end] { f(begin, end); }));
+      }
+    }
+
+    constexpr std::size_t num_pieces(std::size_t first, std::size_t last, std::size_t grain) noexcept {
+      return last > first ? (last - first + grain - 1) / grain : 0;
+    }
+
+    template<typename V>
+    struct split_piece {
+      std::vector<V> values;
+      std::exception_ptr exception;
+      std::atomic<bool> ready{false};
+    };
+
+    // generates the piece into its vector, on a worker of the scheduler
+    template<typename S, typename V>
+    task<> generate_piece(std::shared_ptr<const S> seq, std::shared_ptr<split_piece<V>> piece,
+                          std::size_t begin, std::size_t end) {
+      try {
+        piece->values = to_vector(seq->split(begin, end), end - begin);
+      } catch (...) {
+        piece->exception = std::current_exception();
+      }
+      piece->ready.store(true, std::memory_order_release);
+      piece->ready.notify_one();
+      co_return;
+    }
+
+  } // namespace detail
+
+  /**
+   * A splittable_generator of the values at(0), at(1), ... of an indexed function,
+   * i.e., of a sequence whose values can each be computed from their index alone:
+   * ```
+   *     coro::indexed_sequence squares{[](std::size_t i) { return i * i; }};
+   *     coro::parallel_generate_into(sched, squares, 0, std::span{table});
+   * ```
+   * The generators of its pieces write their values via a fill hook (refer to
+   * sequence_hooks), so generate_into() does not resume them per value.
+   *
+   * @tparam F invoked on the index of each value, and possibly concurrently
+   */
+  template<typename F> requires std::invocable<const F&, std::size_t> && std::copy_constructible<F>
+  class indexed_sequence {
+  public:
+    using value_type = std::remove_cvref_t<std::invoke_result_t<const F&, std::size_t>>;
+  private:
+    F at;
+  public:
+    explicit indexed_sequence(F f) : at{std::move(f)} {}
+
+    value_type operator[](std::size_t index) const { return std::invoke(at, index); }
+
+    generator<value_type> split(std::size_t first, std::size_t last) const {
+      assert(first <= last);
+      return detail::indexed_range(at, first, last);
+    }
+  };
+
+  /**
+   * Writes the values at the indices [first, first + out.size()) of the sequence into
+   * out, in pieces of grain values that are generated concurrently on the workers of
+   * the scheduler - each piece into its own part of out, so the result is the same as
+   * that of seq.split(first, first + out.size()).generate_into(out). Blocks until all
+   * the pieces have completed (so must not be called by a worker of the scheduler),
+   * and rethrows the first exception to have escaped any of them.
+   *
+   * @param sched the scheduler to run the pieces on
+   * @param seq the sequence to generate
+   * @param first the index of the value to write to out[0]
+   * @param out the values to write
+   * @param grain the number of values per piece, i.e., per task
+   */
+  template<splittable_generator S>
+  void parallel_generate_into(scheduler& sched, const S& seq, std::size_t first, std::span<split_value_t<S>> out,
+                              std::size_t grain = 4096) {
+    assert(grain > 0);
+    const auto last = first + out.size();
+    detail::split_join join{detail::num_pieces(first, last, grain)};
+    const auto piece = [&seq, &out, first](std::size_t begin, std::size_t end) {
+      [[maybe_unused]] const auto n = seq.split(begin, end).generate_into(out.subspan(begin - first, end - begin));
+      assert(n == end - begin);
+    };
+    detail::spawn_pieces(sched, join, first, last, grain, piece);
+    join.wait();
+  }
+
+  /**
+   * Invokes f on each value at the indices [first, last) of the sequence, in pieces
+   * of grain values that are generated concurrently on the workers of the scheduler:
+   * f is invoked concurrently, in index order within a piece but in no particular
+   * order across pieces. Blocks until all the pieces have completed (so must not be
+   * called by a worker of the scheduler), and rethrows the first exception to have
+   * escaped any of them.
+   *
+   * @param sched the scheduler to run the pieces on
+   * @param seq the sequence to generate
+   * @param first the index of the first value
+   * @param last the index past the last value
+   * @param f invoked on each value (a reference to it)
+   * @param grain the number of values per piece, i.e., per task
+   */
+  template<splittable_generator S, typename F>
+  void parallel_for_each(scheduler& sched, const S& seq, std::size_t first, std::size_t last, F f,
+                         std::size_t grain = 4096) {
+    assert(grain > 0);
+    detail::split_join join{detail::num_pieces(first, last, grain)};
+    const auto piece = [&seq, &f](std::size_t begin, std::size_t end) {
+      for (auto gen = seq.split(begin, end); gen.next(); ) {
+        std::invoke(f, gen.getValueRef());
+      }
+    };
+    detail::spawn_pieces(sched, join, first, last, grain, piece);
+    join.wait();
+  }
+
+  /**
+   * Returns a generator of the values at the indices [first, last) of the sequence, in
+   * index order, whose pieces of grain values are generated ahead of the consumer on
+   * the workers of the scheduler - up to lookahead pieces at a time, each into a
+   * vector of its own. The consumer blocks (rather than suspends) whilst the piece it
+   * has reached is still being generated. An exception escaping a piece is rethrown
+   * to the consumer after the values of the pieces before it.
+   *
+   * Destroying the generator abandons the pieces still being generated, which keep a
+   * copy of the sequence alive until they complete - the scheduler must outlive them,
+   * e.g., via scheduler::wait().
+   *
+   * @param sched the scheduler to run the pieces on
+   * @param seq the sequence to generate
+   * @param first the index of the first value
+   * @param last the index past the last value
+   * @param grain the number of values per piece, i.e., per task
+   * @param lookahead the number of pieces generated ahead of the consumer (by default, two per worker)
+   * @return coroutine task iterator
+   */
+  template<splittable_generator S>
+  generator<split_value_t<S>> parallel_sequence(scheduler& sched, S seq, std::size_t first, std::size_t last,
+                                                std::size_t grain = 4096, std::size_t lookahead = 0) {
+    assert(grain > 0);
+    using value_type = split_value_t<S>;
+    using piece_type = detail::split_piece<value_type>;
+    if (lookahead == 0) lookahead = 2 * sched.size();
+    const auto shared_seq = std::make_shared<const S>(std::move(seq));
+    std::deque<std::shared_ptr<piece_type>> in_flight;
+    std::size_t next = first;
+    const auto submit = [&] {
+      while (next < last && in_flight.size() < lookahead) {
+        const auto end = next + std::min(grain, last - next);
+        in_flight.push_back(std::make_shared<piece_type>());
+        sched.spawn(detail::generate_piece(shared_seq, in_flight.back(), next, end));
+        next = end;
+      }
+    };
+    submit();
+    while (!in_flight.empty()) {
+      const auto piece = std::move(in_flight.front());
+      in_flight.pop_front();
+      submit(); // keeps lookahead pieces in flight whilst this one is consumed
+      piece->ready.wait(false, std::memory_order_acquire);
+      if (piece->exception) std::rethrow_exception(piece->exception);
+      for (auto& value : piece->values) {
+        co_yield value;
+      }
+    }
+  }
+
+} // namespace coro
+
+#endif //SPLITTABLE_GENERATOR_H
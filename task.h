@@ -0,0 +1,228 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * A lazily started C++20 coroutine task, which the awaiting coroutine resumes
+ * via symmetric transfer and which resumes its awaiter (likewise) once it has
+ * completed, plus sync_wait() for awaiting a task from outside of any coroutine.
+ */
+#ifndef TASK_H
+#define TASK_H
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <source_location>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+#include "generator.h"
+
+namespace coro {
+
+  namespace detail {
+
+    template<typename T>
+    struct task_result {
+      std::optional<T> value{};
+      template<typename U = T> requires std::convertible_to<U&&, T>
+      void return_value(U&& u) {
+        value.emplace(std::forward<U>(u));
+      }
+    };
+
+    template<>
+    struct task_result<void> {
+      void return_void() noexcept {}
+    };
+
+  } // namespace detail
+
+  /**
+   * Coroutine task template class - the coroutine body starts executing once the
+   * task is co_await-ed (the task itself keeps ownership of the coroutine frame).
+   * Awaiting the task as an rvalue moves the result out of it, whereas awaiting it as
+   * an lvalue yields a reference to the result.
+   *
+   * @tparam T the type of the result of the task (or void)
+   * @tparam ExceptionPolicy what becomes of an exception escaping the coroutine (refer to generator.h)
+   * @tparam AllocationPolicy how the coroutine frame is allocated (refer to generator.h)
+   */
+  template<typename T = void, exception_policy ExceptionPolicy = propagate_exceptions,
+           allocation_policy AllocationPolicy = pmr_allocation>
+  class [[nodiscard]] task {
+  public:
+    struct promise_type;
+    using coro_handle_type = std::coroutine_handle<promise_type>;
+  private:
+    coro_handle_type coro;
+  public:
+    explicit task(coro_handle_type h) : coro{h} {}
+    task(const task &) = delete;            // do not allow copy construction
+    task &operator=(const task &) = delete; // do not allow copy assignment
+    task(task &&oth) noexcept : coro{std::exchange(oth.coro, nullptr)} {}
+    task &operator=(task &&other) noexcept {
+      if (this != &other) { // ignore assignment to self
+        if (coro) {         // destroy self current handle
+          coro.destroy();
+        }
+        coro = std::exchange(other.coro, nullptr);
+      }
+      return *this;
+    }
+    ~task() {
+      if (coro) {
+        coro.destroy();
+        coro = nullptr;
+      }
+    }
+
+    bool done() const noexcept {
+      return !coro || coro.done();
+    }
+
+  public:
+    // implementation of above opaque declaration promise_type
+    struct promise_type : promise_allocation<AllocationPolicy>, promise_exception<ExceptionPolicy>,
+                          detail::task_result<T> {
+    private:
+      std::coroutine_handle<> continuation = std::noop_coroutine(); // the awaiting coroutine
+      friend class task;
+
+      struct final_awaiter {
+        constexpr bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(coro_handle_type h) noexcept {
+          return h.promise().continuation;
+        }
+        constexpr void await_resume() const noexcept {}
+      };
+    public:
+      // the default argument is the source location of the coroutine (task) function
+      promise_type(const std::source_location& loc = std::source_location::current()) {
+        this->record_frame_size(loc);
+      }
+      promise_type(const promise_type&) = delete;
+      promise_type &operator=(const promise_type&) = delete;
+
+      auto get_return_object() {
+        return task{coro_handle_type::from_promise(*this)};
+      }
+
+      auto initial_suspend() noexcept {
+        return std::suspend_always{};
+      }
+
+      auto final_suspend() noexcept {
+        return final_awaiter{};
+      }
+    };
+
+  private:
+    template<bool Move>
+    struct awaiter {
+      coro_handle_type coro;
+      bool await_ready() const noexcept {
+        return !coro || coro.done();
+      }
+      coro_handle_type await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        coro.promise().continuation = awaiting;
+        return coro; // start (or continue) the task
+      }
+      decltype(auto) await_resume() {
+        assert(coro && coro.done());
+        coro.promise().rethrow_if_exception();
+        if constexpr (!std::is_void_v<T>) {
+          if constexpr (Move) {
+            return std::move(*coro.promise().value);
+          } else {
+            return static_cast<T&>(*coro.promise().value);
+          }
+        }
+      }
+    };
+
+  public:
+    auto operator co_await() & noexcept {
+      return awaiter<false>{coro};
+    }
+    auto operator co_await() && noexcept {
+      return awaiter<true>{coro};
+    }
+
+    // awaits the completion of the task without retrieving its result (or rethrowing its exception)
+    auto when_ready() noexcept {
+      struct ready_awaiter : awaiter<false> {
+        constexpr void await_resume() const noexcept {}
+      };
+      return ready_awaiter{{coro}};
+    }
+  };
+
+  namespace detail {
+
+    // resumed by the task that it awaits, once the task is done, on whatever thread completes it
+    struct sync_wait_driver {
+      struct promise_type {
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done = false;
+
+        struct notify_awaiter {
+          constexpr bool await_ready() const noexcept { return false; }
+          void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+            auto& p = h.promise();
+            std::lock_guard<std::mutex> lk{p.mtx}; // notify while locked, as the waiter then destroys the frame
+            p.done = true;
+            p.cv.notify_one();
+          }
+          constexpr void await_resume() const noexcept {}
+        };
+
+        sync_wait_driver get_return_object() {
+          return sync_wait_driver{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        notify_awaiter final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        [[noreturn]] void unhandled_exception() noexcept { std::terminate(); } // await_ready() of a task does not throw
+      };
+
+      std::coroutine_handle<promise_type> hdl;
+
+      explicit sync_wait_driver(std::coroutine_handle<promise_type> h) noexcept : hdl{h} {}
+      sync_wait_driver(const sync_wait_driver&) = delete;
+      sync_wait_driver& operator=(const sync_wait_driver&) = delete;
+      ~sync_wait_driver() {
+        hdl.destroy();
+      }
+
+      void run_to_completion() {
+        hdl.resume();
+        auto& p = hdl.promise();
+        std::unique_lock<std::mutex> lk{p.mtx};
+        p.cv.wait(lk, [&p] { return p.done; });
+      }
+    };
+
+    template<typename Task>
+    sync_wait_driver await_completion(Task& t) {
+      co_await t.when_ready();
+    }
+
+  } // namespace detail
+
+  /**
+   * Blocks the calling thread until the task has completed - the task starts
+   * executing on the calling thread, but may be completed on another thread,
+   * e.g., by an I/O completion - and returns its result (or rethrows its exception).
+   */
+  template<typename T, typename ExceptionPolicy, typename AllocationPolicy>
+  T sync_wait(task<T, ExceptionPolicy, AllocationPolicy>&& t) {
+    detail::await_completion(t).run_to_completion();
+    return std::move(t).operator co_await().await_resume();
+  }
+
+} // namespace coro
+
+#endif //TASK_H
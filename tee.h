@@ -0,0 +1,241 @@
+/**
+ * Created by github roger-dv on 10/14/2026
+ *
+ * The tee() adaptor, which runs one generator once and shares its values with
+ * several independent readers - each a generator of its own - via a segmented
+ * buffer that is freed as the slowest reader passes it. The readers of
+ * tee<std::mutex>() may be iterated on different threads.
+ */
+#ifndef TEE_H
+#define TEE_H
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <assert.h>
+#include "generator.h"
+
+namespace coro {
+
+  // a mutex that does not lock, for tee() readers that are all iterated on one thread
+  struct null_mutex {
+    constexpr void lock() noexcept {}
+    constexpr bool try_lock() noexcept { return true; }
+    constexpr void unlock() noexcept {}
+  };
+
+  namespace detail {
+
+    /**
+     * The source generator of tee() and the values it yielded that some reader has
+     * yet to pass, in a singly linked list of fixed capacity segments. A segment is
+     * freed once each reader that was active when it was created has passed it (or
+     * was destroyed) - as readers pass the segments in order, those are always at
+     * the head of the list. The values of a segment are not moved once constructed,
+     * so readers yield them by reference, and only take the mutex to learn of how
+     * many values follow in the segment (and to pull the source for more of them).
+     */
+    template<typename G, typename Mutex>
+    class tee_state {
+    public:
+      using value_type = typename G::value_type;
+
+      struct segment {
+        value_type* values;
+        std::size_t count = 0;
+        std::size_t remaining; // the readers that have yet to pass the segment
+        std::unique_ptr<segment> next;
+      };
+
+      // the position of a reader, i.e., of the value it yields next
+      struct cursor {
+        segment* seg;
+        std::size_t offset = 0;
+      };
+
+      // values that a reader can yield without taking the mutex (as a generator of const values)
+      struct run {
+        value_type* values = nullptr;
+        std::size_t count = 0;
+      };
+    private:
+      G source;
+      const std::size_t segment_size;
+      Mutex mtx;
+      std::unique_ptr<segment> head;
+      segment* tail;
+      std::size_t active_readers;
+      bool finished = false;
+      std::exception_ptr exception;
+
+      segment* make_segment() {
+        return new segment{std::allocator<value_type>{}.allocate(segment_size), 0, active_readers, nullptr};
+      }
+
+      static void destroy_segment(segment* seg, std::size_t segment_size) noexcept {
+        std::destroy_n(seg->values, seg->count);
+        std::allocator<value_type>{}.deallocate(seg->values, segment_size);
+      }
+
+      void free_passed_segments() noexcept {
+        while (head && head->remaining == 0 && head.get() != tail) {
+          destroy_segment(head.get(), segment_size);
+          head = std::move(head->next);
+        }
+      }
+
+      // appends the next value of the source to the tail segment, unless the source has completed
+      bool pull() {
+        if (finished) return false;
+        try {
+          if (!source.next()) {
+            finished = true;
+            return false;
+          }
+          if (tail->count == segment_size) {
+            tail->next.reset(make_segment());
+            tail = tail->next.get();
+          }
+          auto& value = source.getValueRef();
+          if constexpr (std::is_copy_constructible_v<value_type>) {
+            std::construct_at(tail->values + tail->count, std::as_const(value));
+          } else { // the value of a generator of a move-only type can only be consumed by moving from it
+            std::construct_at(tail->values + tail->count, std::move(value));
+          }
+          tail->count++;
+          return true;
+        } catch (...) {
+          exception = std::current_exception();
+          finished = true;
+          return false;
+        }
+      }
+    public:
+      tee_state(G&& gen, std::size_t num_readers, std::size_t seg_size)
+        : source{std::move(gen)}, segment_size{seg_size}, active_readers{num_readers} {
+        head.reset(make_segment());
+        tail = head.get();
+      }
+      tee_state(const tee_state&) = delete;
+      tee_state& operator=(const tee_state&) = delete;
+      ~tee_state() {
+        for (auto seg = std::move(head); seg; seg = std::move(seg->next)) {
+          destroy_segment(seg.get(), segment_size);
+        }
+      }
+
+      cursor first() const noexcept { return cursor{head.get()}; }
+
+      /**
+       * Returns the values that follow the cursor in its segment - pulling the source
+       * for the next value should there be none - or an empty run once the source has
+       * completed. Moves the cursor past a segment that it has passed entirely.
+       */
+      run fetch(cursor& c) {
+        std::lock_guard<Mutex> lk{mtx};
+        while (c.offset == c.seg->count) {
+          if (c.offset == segment_size && c.seg->next) { // on to the next segment
+            segment* passed = c.seg;
+            c.seg = passed->next.get();
+            c.offset = 0;
+            passed->remaining--;
+            free_passed_segments();
+          } else if (!pull()) {
+            return {};
+          }
+        }
+        return run{c.seg->values + c.offset, c.seg->count - c.offset};
+      }
+
+      // the reader at the cursor is destroyed, so need no longer be waited for by the segments to come
+      void leave(const cursor& c) noexcept {
+        std::lock_guard<Mutex> lk{mtx};
+        for (segment* seg = c.seg; seg != nullptr; seg = seg->next.get()) {
+          seg->remaining--;
+        }
+        active_readers--;
+        free_passed_segments();
+      }
+
+      void rethrow_if_exception() {
+        std::lock_guard<Mutex> lk{mtx};
+        if (exception) std::rethrow_exception(exception);
+      }
+    };
+
+    // a reader's share of the tee_state, which it leaves when its generator is destroyed - even if it never started
+    template<typename S>
+    class tee_lease {
+    private:
+      std::shared_ptr<S> state;
+    public:
+      typename S::cursor position;
+      explicit tee_lease(std::shared_ptr<S> s) noexcept : state{std::move(s)}, position{state->first()} {}
+      tee_lease(tee_lease&& other) noexcept : state{std::move(other.state)}, position{other.position} {}
+      tee_lease& operator=(tee_lease&&) = delete;
+      ~tee_lease() {
+        if (state) state->leave(position);
+      }
+      S& shared() const noexcept { return *state; }
+    };
+
+    template<typename S>
+    generator<const typename S::value_type> tee_reader(tee_lease<S> lease) {
+      auto& state = lease.shared();
+      for (auto values = state.fetch(lease.position); values.count > 0; values = state.fetch(lease.position)) {
+        for (std::size_t k = 0; k < values.count; k++) {
+          co_yield values.values[k]; // by reference to the kept value
+        }
+        lease.position.offset += values.count;
+      }
+      state.rethrow_if_exception();
+    }
+
+  } // namespace detail
+
+  /**
+   * Turns the generator into num_readers generators that each yield all of its
+   * values, whilst the generator itself runs just once: whichever reader is ahead
+   * resumes it for the next value, which is kept (in segments of segment_size
+   * values) until the slowest reader has passed it. The readers yield const
+   * references to the kept values, i.e., without a copy per reader; each value is
+   * copied from the generator once (or moved, for a move-only value type).
+   *
+   * The readers of tee() must be iterated on one thread. The readers of
+   * tee<std::mutex>() may be iterated concurrently, on different threads: they
+   * yield the values that have been kept without locking, but take the mutex to
+   * learn of more of them and to resume the generator (the mutex is held whilst
+   * the generator computes the next value).
+   *
+   * A reader that falls behind keeps the values it has yet to yield, i.e., memory
+   * use is bounded only by how far apart the readers are. A reader destroyed before
+   * it completed no longer holds back the others. An exception escaping the
+   * generator is rethrown to each of the readers after the values that preceded it.
+   *
+   * @tparam Mutex the mutex guarding the shared state, e.g., null_mutex or std::mutex
+   * @param gen the generator to share
+   * @param num_readers the number of readers (and returned generators)
+   * @param segment_size the number of values per segment of the shared buffer
+   * @return the generator of each reader
+   */
+  template<typename Mutex = null_mutex, typename T, typename ExceptionPolicy, typename AllocationPolicy>
+  std::vector<generator<const std::remove_cv_t<T>>> tee(generator<T, ExceptionPolicy, AllocationPolicy> gen,
+                                                        std::size_t num_readers, std::size_t segment_size = 256) {
+    assert(num_readers > 0 && segment_size > 0);
+    using state_type = detail::tee_state<generator<T, ExceptionPolicy, AllocationPolicy>, Mutex>;
+    auto state = std::make_shared<state_type>(std::move(gen), num_readers, segment_size);
+    std::vector<generator<const std::remove_cv_t<T>>> readers;
+    readers.reserve(num_readers);
+    for (std::size_t k = 0; k < num_readers; k++) {
+      readers.push_back(detail::tee_reader(detail::tee_lease{state}));
+    }
+    return readers;
+  }
+
+} // namespace coro
+
+#endif //TEE_H